@@ -25,6 +25,9 @@ int main()
     slice=s(0,3,2); // s[0:3:2]
     PROTON_THROW_IF(len(slice)!=2, "slice with step err");
 
+    auto v=s.view(0,3,2); // s[0:3:2] without copying
+    PROTON_THROW_IF(len(v)!=2 || v[1]!="c" || &v[1]!=&s[2], "view err");
+
     slice=slice*2;
     PROTON_THROW_IF(len(slice)!=4, "slice*2 err");
 
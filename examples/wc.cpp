@@ -1,10 +1,16 @@
+#include <chrono>
+#include <thread>
+#include <fstream>
+#include <iomanip>
 #include <proton/base.hpp>
 #include <proton/getopt.hpp>
 #include <proton/io.hpp>
 #include <proton/string.hpp>
+#include <proton/detail/scan.hpp>
 
 using namespace std;
 using namespace proton;
+using namespace proton::detail;
 
 void usage()
 {
@@ -13,30 +19,113 @@ void usage()
 "  -c, --bytes            print the byte counts\n"
 "  -l, --lines            print the newline counts\n"
 "  -w, --words            print the word counts\n"
+"  -j, --jobs=N           count in N threads, the number of cpus by default\n"
+"      --bench            time the counting of each file and report GB/s\n"
 "      --help     display this help and exit\n"
     << endl;
 }
 
-tuple<long, long, long> count_file(const str& fn, bool cb, bool cw, bool cl)
+typedef tuple<long, long, long> counts_t; // bytes, words, lines
+
+// files are split into chunks of at least this size for threads
+const size_t min_chunk=1<<20;
+
+// the delimiters of isplit() by default
+const char_set spaces(" \t\r\n", 4);
+
+// the first version, like wc.py: readline(), split() into strs and tellg() per line
+counts_t count_readline(const str& fn)
 {
     long total_bytes=0, total_words=0, total_lines=0;
 
-    fstream f(fn.c_str());
+    ifstream f(fn.c_str(), ios::binary);
+    if(!f)
+        throw system_error(errno, generic_category(), fn.c_str());
     str line;
     while(len(line=readline(f))){
         total_lines++;
         auto words=line.split();
         total_words+=len(words);
-        total_bytes=f.tellg();
+        long pos=(long)f.tellg();
+        total_bytes=(pos<0 ? total_bytes+len(line) : pos); // -1 after a last line without '\n'
+    }
+    return _t(total_bytes, total_words, total_lines);
+}
+
+// lines by line_reader, words by isplit() over them
+counts_t count_line_reader(const str& fn)
+{
+    long total_words=0, total_lines=0;
+
+    line_reader f(fn.c_str());
+    for(auto line: f){
+        total_lines++;
+        auto words=isplit(line);
+        total_words+=std::distance(words.begin(), words.end());
     }
-    return _t(total_bytes,total_words,total_lines);
+    return _t((long)f.offset(),total_words,total_lines);
+}
+
+// newlines and words of [b,e), the char before b being a delimiter if after_space
+void count_chunk(const char* b, const char* e, bool after_space, long& words, long& lines)
+{
+    words=(long)scan_count_tokens(b, e, spaces, after_space);
+    lines=(long)scan_count(b, e, '\n');
+}
+
+// the whole file mapped, chunks counted in threads; a word across two chunks is
+// counted in the chunk it starts in
+counts_t count_mapped(const str& fn, size_t jobs)
+{
+    mapped_file m(fn.c_str());
+    const char* p=m.data();
+    size_t n=m.size();
+
+    jobs=std::max(std::min(jobs, n/min_chunk), (size_t)1);
+    vector<long> words(jobs), lines(jobs);
+    vector<thread> threads;
+    for(size_t i=0; i<jobs; i++){
+        const char* b=p+n*i/jobs;
+        const char* e=p+n*(i+1)/jobs;
+        bool after_space=(b==p || spaces.has(b[-1]));
+        if(i+1==jobs)
+            count_chunk(b, e, after_space, words[i], lines[i]);
+        else
+            threads.emplace_back(count_chunk, b, e, after_space, ref(words[i]), ref(lines[i]));
+    }
+    for(auto& t: threads)
+        t.join();
+
+    long total_words=0, total_lines=0;
+    for(size_t i=0; i<jobs; i++){
+        total_words+=words[i];
+        total_lines+=lines[i];
+    }
+    // a last line without '\n' counts, as in count_line_reader()
+    if(n && p[n-1]!='\n')
+        total_lines++;
+    return _t((long)n, total_words, total_lines);
+}
+
+// time f() over fn, and check it against the counts r
+template<typename F>
+void bench(const char* name, const str& fn, F f, const counts_t& r)
+{
+    auto t0=chrono::steady_clock::now();
+    counts_t x=f(fn);
+    double s=chrono::duration<double>(chrono::steady_clock::now()-t0).count();
+    cout << "  " << left << setw(12) << name << right << fixed << setprecision(3)
+         << setw(10) << s*1e3 << " ms" << setw(9) << get<0>(x)/s/1e9 << " GB/s";
+    if(x!=r)
+        cout << "  MISMATCH " << x;
+    cout << endl;
 }
 
 int main(int argc, char** argv)
 {
     getopt_t g;
     try{
-        g=getopt(argc, argv, "clw", {"bytes","lines","words","help"});
+        g=getopt(argc, argv, "clwj:", {"bytes","lines","words","jobs=","bench","help"});
     }
     catch(invalid_argument& e){
         usage();
@@ -49,15 +138,20 @@ int main(int argc, char** argv)
     bool count_bytes=true;
     bool count_lines=true;
     bool count_words=true;
+    bool bench_mode=false;
+    size_t jobs=std::max(thread::hardware_concurrency(), 1u);
 
-    if(len(opts)>0){
-        count_bytes=false;
-        count_lines=false;
-        count_words=false;
-    }
-
+    bool selected=false;
     for(auto x : opts){
         auto s=at<0>(x);
+        if(s=="-c" || s=="--bytes" || s=="-w" || s=="--words" || s=="-l" || s=="--lines"){
+            if(!selected){
+                count_bytes=false;
+                count_lines=false;
+                count_words=false;
+                selected=true;
+            }
+        }
         if(s=="-c" || s=="--bytes"){
             count_bytes=true;
         }
@@ -67,6 +161,17 @@ int main(int argc, char** argv)
         else if(s=="-l" || s=="--lines"){
             count_lines=true;
         }
+        else if(s=="-j" || s=="--jobs"){
+            int k;
+            if(!get_int(k, at<1>(x)) || k<1){
+                usage();
+                return -1;
+            }
+            jobs=(size_t)k;
+        }
+        else if(s=="--bench"){
+            bench_mode=true;
+        }
         else if(s=="--help"){
             usage();
             return 0;
@@ -75,7 +180,22 @@ int main(int argc, char** argv)
 
     for(auto x:args){
         long bytes, words, lines;
-        tie(bytes, words, lines)=count_file(x, count_bytes, count_words, count_lines);
+        try{
+            tie(bytes, words, lines)=count_mapped(x, jobs);
+            if(bench_mode){
+                cout << x << ": " << bytes << " bytes, " << jobs << " jobs" << endl;
+                counts_t r=_t(bytes, words, lines);
+                bench("readline", x, count_readline, r);
+                bench("line_reader", x, count_line_reader, r);
+                bench("mapped", x, [](const str& fn){ return count_mapped(fn, 1); }, r);
+                bench("mapped -j", x, [jobs](const str& fn){ return count_mapped(fn, jobs); }, r);
+                continue;
+            }
+        }
+        catch(system_error& e){
+            cerr << "wc: " << e.what() << endl;
+            continue;
+        }
         cout << " " ;
         if(count_lines)
             cout << lines << " ";
@@ -88,4 +208,3 @@ int main(int argc, char** argv)
 
     return 0;
 }
-
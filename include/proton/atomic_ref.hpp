@@ -0,0 +1,215 @@
+#ifndef PROTON_ATOMIC_REF_HEADER
+#define PROTON_ATOMIC_REF_HEADER
+
+/** @file atomic_ref.hpp
+ *  @brief a lock-free cell to publish refs across threads.
+ */
+
+#include <atomic>
+#include <cstdint>
+#include <type_traits>
+#include <proton/base.hpp>
+#include <proton/pool.hpp>
+#include <proton/ref.hpp>
+
+namespace proton{
+
+/** @addtogroup ref_
+ * @{
+ */
+
+/** a ref_ type which can be shared across threads.
+ * It is counted atomically, and allocated by sys_allocator.
+ */
+template<typename T, typename traits=ref_traits<T> >
+using aref_=ref_<T, sys_allocator<T>, traits, detail::arefc_t>;
+
+/** A lock-free cell holding a ref, like std::atomic<> for ref_.
+ * Readers never block writers, nor each other.
+ * It uses split reference counts: the cell word packs a pointer to a node holding the ref,
+ * and a local count of the cell itself and of the readers pinning the node.
+ * When a writer replaces the node, it moves the local count into the node's own count,
+ * and the last one leaving the node deletes it.
+ * @param refT a ref type with a thread-safe refc_t, e.g. aref_<T>.
+ */
+template<typename refT>
+class atomic_ref_{
+    static_assert(std::is_same<typename refT::refc_t::support_atomic, int>::value,
+                  "refT must use a thread-safe refc_t, e.g. aref_<T>");
+public:
+    typedef refT ref_t;
+
+private:
+    struct node_t{
+        std::atomic<long> count;
+        const refT r;
+
+        node_t(const refT& x):count(0), r(x)
+        {}
+    };
+
+    typedef unsigned long long word_t;
+
+    static constexpr int ptr_bits=(sizeof(void*)==8)? 48 : 32;
+    static constexpr word_t one=(word_t)1 << ptr_bits;
+    static constexpr word_t ptr_mask=one-1;
+
+    std::atomic<word_t> _w;
+
+private:
+    atomic_ref_(const atomic_ref_&); ///< disabled
+    atomic_ref_& operator=(const atomic_ref_&); ///< disabled
+
+    static node_t* ptr(word_t w)
+    {
+        return (node_t*)(uintptr_t)(w & ptr_mask);
+    }
+
+    static long local(word_t w)
+    {
+        return (long)(w >> ptr_bits);
+    }
+
+    static bool same(const refT& x, const refT& y)
+    {
+        return x._p==y._p;
+    }
+
+    /** a new word referring to x, with the local count of the cell.
+     */
+    static word_t make_word(const refT& x)
+    {
+        if(x==none)
+            return 0;
+        node_t* n=new node_t(x);
+        if((uintptr_t)n & ~(uintptr_t)ptr_mask){
+            delete n;
+            PROTON_ERR("the pointer is too wide to pack in atomic_ref_");
+        }
+        return (word_t)(uintptr_t)n | one;
+    }
+
+    /** move the local count of a replaced word into its node, and drop the count of the cell.
+     */
+    static void retire(word_t w)
+    {
+        node_t* n=ptr(w);
+        if(n){
+            long k=local(w)-1;
+            if(n->count.fetch_add(k, std::memory_order_acq_rel)+k==0)
+                delete n;
+        }
+    }
+
+    /** pin the current node.
+     */
+    node_t* acquire()
+    {
+        return ptr(_w.fetch_add(one, std::memory_order_acquire));
+    }
+
+    /** unpin a node got from acquire().
+     */
+    void unacquire(node_t* n)
+    {
+        word_t cur=_w.load(std::memory_order_relaxed);
+        while(ptr(cur)==n){
+            if(_w.compare_exchange_weak(cur, cur-one, std::memory_order_release,
+                                        std::memory_order_relaxed))
+                return;
+        }
+        // replaced, and our pin has been moved into the node
+        if(n && n->count.fetch_sub(1, std::memory_order_acq_rel)==1)
+            delete n;
+    }
+
+public:
+    /** ctor.
+     * @param x the initial ref
+     */
+    atomic_ref_(const refT& x=refT()):_w(make_word(x))
+    {}
+
+    ~atomic_ref_()
+    {
+        retire(_w.load(std::memory_order_acquire));
+    }
+
+    /** get a snapshot of the current ref.
+     */
+    refT load()
+    {
+        node_t* n=acquire();
+        refT r;
+        if(n)
+            r=n->r;
+        unacquire(n);
+        return r;
+    }
+
+    /** replace the current ref.
+     */
+    void store(const refT& x)
+    {
+        retire(_w.exchange(make_word(x), std::memory_order_acq_rel));
+    }
+
+    /** replace the current ref, and return the old one.
+     */
+    refT exchange(const refT& x)
+    {
+        word_t old=_w.exchange(make_word(x), std::memory_order_acq_rel);
+        refT r;
+        if(ptr(old))
+            r=ptr(old)->r;
+        retire(old);
+        return r;
+    }
+
+    /** replace the current ref by desired if it refers to the same object as expected.
+     * @param expected the expected ref, updated to the current one on failure
+     * @param desired the new ref
+     * @return true: replaced, false: not
+     */
+    bool compare_exchange(refT& expected, const refT& desired)
+    {
+        word_t nw=0;
+        while(true){
+            node_t* n=acquire();
+            if(n ? !same(n->r, expected) : expected!=none){
+                expected=(n ? n->r : refT());
+                unacquire(n);
+                if(ptr(nw))
+                    delete ptr(nw);
+                return false;
+            }
+            if(!nw)
+                nw=make_word(desired);
+            word_t cur=_w.load(std::memory_order_relaxed);
+            while(ptr(cur)==n){
+                if(_w.compare_exchange_weak(cur, nw, std::memory_order_acq_rel,
+                                            std::memory_order_relaxed)){
+                    retire(cur);
+                    unacquire(n);
+                    return true;
+                }
+            }
+            unacquire(n);
+        }
+    }
+
+    /** true if the cell word is lock-free on this platform.
+     */
+    bool is_lock_free()const
+    {
+        return _w.is_lock_free();
+    }
+};
+
+/**
+ * @}
+ */
+
+} // ns proton
+
+#endif // PROTON_ATOMIC_REF_HEADER
@@ -0,0 +1,215 @@
+#ifndef PROTON_CYCLE_HEADER
+#define PROTON_CYCLE_HEADER
+
+/** @file cycle.hpp
+ *  @brief a cycle collector for ref_ object graphs.
+ */
+
+#include <utility>
+#include <type_traits>
+#include <proton/base.hpp>
+#include <proton/pool.hpp>
+#include <proton/ref.hpp>
+
+namespace proton{
+
+class cc_visitor;
+
+/** collect garbage cycles of cycref_ objects.
+ * It scans the graphs reachable from the buffered possible roots, and frees objects
+ * only referred by each other.
+ * @param budget stop taking more roots once this number of objects are scanned, so a call
+ *        pauses for a bounded time except for a single huge graph. Left roots are scanned in
+ *        the next calls.
+ * @return the number of freed objects
+ */
+size_t collect_cycles(size_t budget=size_t(-1));
+
+/** get the number of buffered possible roots.
+ */
+size_t cycle_roots();
+
+namespace detail{
+
+/** a refc_t supporting the cycle collector.
+ * When a count drops but not to 0, the object is buffered as a possible root of a garbage cycle.
+ * collect_cycles() then finds cycles only referred by themselves (trial deletion, Bacon-Rajan),
+ * using a trial count, so the real counts are never touched.
+ * Not thread-safe.
+ */
+class crefc_t {
+    friend class proton::cc_visitor;
+    friend size_t proton::collect_cycles(size_t budget);
+public:
+    typedef int support_cycle;
+    typedef void (*trace_fn)(void* obj, cc_visitor& v);
+    typedef void (*free_fn)(void* p);
+
+    enum color_t{
+        black,  // in use
+        gray,   // being scanned
+        white   // garbage, being collected
+    };
+
+private:
+    long __r;
+    long __trial;
+    unsigned char __color;
+    bool __buffered;
+    void* __obj;    // NULL: destroyed
+    trace_fn __trace;
+    free_fn __destruct;
+    free_fn __free;
+
+public:
+    crefc_t():__r(0), __trial(0), __color(black), __buffered(false), __obj(NULL)
+    {}
+
+    crefc_t(const crefc_t& r):__r(0), __trial(0), __color(black), __buffered(false), __obj(NULL)
+    {}
+
+    crefc_t& operator=(const crefc_t& r)
+    {
+        return *this;
+    }
+
+    void enter()
+    {
+        ++__r;
+    }
+
+    long release()
+    {
+        return --__r;
+    }
+
+    long count() const
+    {
+        return __r;
+    }
+
+    static constexpr long weak_count()
+    {
+        return 0;
+    }
+
+    /** called by ref_ when the object is constructed.
+     */
+    void bind(void* obj, trace_fn trace, free_fn destruct, free_fn free)
+    {
+        __obj=obj;
+        __trace=trace;
+        __destruct=destruct;
+        __free=free;
+    }
+
+    /** called by ref_ when the count drops but not to 0.
+     */
+    void decreased()
+    {
+        if(!__buffered && __color==black){
+            __buffered=true;
+            buffer_root(this);
+        }
+    }
+
+    /** called by ref_ when the count drops to 0.
+     */
+    void dispose()
+    {
+        if(__color==white) // the collector will free it
+            return;
+        void* obj=__obj;
+        __obj=NULL;
+        __destruct(obj);
+        if(!__buffered) // otherwise freed when the collector meets it in roots
+            __free(this);
+    }
+
+protected:
+    static void buffer_root(crefc_t* rc);
+};
+
+} // ns detail
+
+/** @addtogroup ref_
+ * @{
+ */
+
+/** a ref_ type supporting the cycle collector.
+ * obj_t must implement: void trace(cc_visitor& v)const, calling v(x) for each
+ * outgoing ref or container of refs x.
+ */
+template<typename T, typename traits=ref_traits<T> >
+using cycref_=ref_<T, smart_allocator<T>, traits, detail::crefc_t>;
+
+/** the visitor passed to trace() of objects in cycref_.
+ * v(x) accepts refs, containers of refs, pairs and tuples of them, and ignores other values.
+ */
+class cc_visitor{
+protected:
+    virtual void visit(detail::crefc_t* rc)=0;
+
+    template<typename O, typename A, typename T>
+    void item(const ref_<O,A,T,detail::crefc_t>& x, int)
+    {
+        if(x._rp)
+            visit(x._rp);
+    }
+
+    template<typename K, typename V>
+    void item(const std::pair<K,V>& x, int)
+    {
+        item(x.first, 0);
+        item(x.second, 0);
+    }
+
+    template<size_t i, typename ...T>
+    typename std::enable_if<i==sizeof...(T)>::type item_tuple(const std::tuple<T...>& x)
+    {}
+
+    template<size_t i, typename ...T>
+    typename std::enable_if<(i<sizeof...(T))>::type item_tuple(const std::tuple<T...>& x)
+    {
+        item(std::get<i>(x), 0);
+        item_tuple<i+1>(x);
+    }
+
+    template<typename ...T>
+    void item(const std::tuple<T...>& x, int)
+    {
+        item_tuple<0>(x);
+    }
+
+    template<typename C>
+    auto item(const C& x, int) -> typename std::enable_if<
+            !std::is_arithmetic<typename C::value_type>::value,
+            decltype(void(x.begin()))>::type
+    {
+        for(auto& i: x)
+            item(i, 0);
+    }
+
+    template<typename X>
+    void item(const X& x, long)
+    {}
+
+public:
+    virtual ~cc_visitor()
+    {}
+
+    template<typename X>
+    cc_visitor& operator()(const X& x)
+    {
+        item(x, 0);
+        return *this;
+    }
+};
+
+/**
+ * @}
+ */
+
+} // ns proton
+
+#endif // PROTON_CYCLE_HEADER
@@ -0,0 +1,117 @@
+#ifndef PROTON_DEFERRED_HEADER
+#define PROTON_DEFERRED_HEADER
+
+/** @file deferred.hpp
+ *  @brief deferred destruction of ref_ objects.
+ */
+
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <proton/base.hpp>
+#include <proton/pool.hpp>
+#include <proton/ref.hpp>
+
+namespace proton{
+
+namespace detail{
+
+/** an object waiting for destruction in the retire list.
+ */
+struct retired_t{
+    retired_t* next;
+    void* rc;
+    void* obj;
+    void (*destroy)(void* rc, void* obj);
+};
+
+/** push an object to a retire list.
+ * @param shared true to push to the global list, thread-safe and lock-free, for objects
+ *        that any thread can destroy; false to push to the list of the calling thread
+ */
+void retire(retired_t* r, bool shared);
+
+/** a refc_t deferring the destruction of objects.
+ * When the count drops to 0, the object is put into the retire list instead of
+ * being destroyed, so the thread releasing the last ref doesn't pay for it.
+ * The object is destroyed later by collect(), or by a reclaimer.
+ * @param refcT the counting policy, e.g. refc_t, or arefc_t for refs shared across threads.
+ */
+template<typename refcT=refc_t>
+class drefc_t:public refcT {
+public:
+    typedef int support_deferred;
+
+private:
+    retired_t __d;
+
+public:
+    void retire(void* obj, void (*destroy)(void* rc, void* obj), bool shared)
+    {
+        __d.rc=this;
+        __d.obj=obj;
+        __d.destroy=destroy;
+        detail::retire(&__d, shared);
+    }
+};
+
+} // ns detail
+
+/** @addtogroup ref_
+ * @{
+ */
+
+/** a ref_ type deferring the destruction of its objects.
+ */
+template<typename T, typename traits=ref_traits<T> >
+using dref_=ref_<T, smart_allocator<T>, traits, detail::drefc_t<> >;
+
+/** destroy objects in the retire lists.
+ * Objects of refs counted atomically and allocated by a thread-safe allocator, like
+ * aref_ with detail::drefc_t<detail::arefc_t>, go to a global list collected by any
+ * thread. Others, like dref_, go to a list of the thread releasing them, which only
+ * that thread collects, as the pools of smart_allocator are not thread-safe.
+ * Objects retired during the collection, e.g. refs held by a destroyed object,
+ * are collected in the same call.
+ * @param max the max number of objects to destroy in this call
+ * @return the number of destroyed objects
+ */
+size_t collect(size_t max=size_t(-1));
+
+/** get the number of objects waiting in the global retire list and in the one of this thread.
+ */
+size_t retired_count();
+
+/** a background thread calling collect() periodically.
+ * It destroys the objects in the global retire list only, see collect().
+ */
+class reclaimer{
+protected:
+    std::mutex _m;
+    std::condition_variable _cv;
+    bool _stop;
+    std::thread _t;
+
+private:
+    reclaimer(const reclaimer&); ///< disabled
+    reclaimer& operator=(const reclaimer&); ///< disabled
+
+public:
+    /** ctor.
+     * @param interval_ms the interval between two collections, in ms.
+     */
+    explicit reclaimer(long interval_ms=10);
+
+    /** stop the thread, then collect() in the calling thread.
+     */
+    ~reclaimer();
+};
+
+/**
+ * @}
+ */
+
+} // ns proton
+
+#endif // PROTON_DEFERRED_HEADER
@@ -17,6 +17,7 @@
 #include <proton/base.hpp>
 #include <proton/pool.hpp>
 #include <proton/ref.hpp>
+#include <proton/slice.hpp>
 
 namespace proton{
 
@@ -250,13 +251,13 @@ public:
 
     /** move ctor.
      */
-    deque_(deque_&& x)noexcept:baseT(x)
+    deque_(deque_&& x)noexcept:baseT(std::move(x))
     {}
 
     explicit deque_(const baseT& x):baseT(x)
     {}
 
-    deque_(baseT&& x)noexcept:baseT(x)
+    deque_(baseT&& x)noexcept:baseT(std::move(x))
     {}
 
     /** assign.
@@ -269,7 +270,7 @@ public:
 
     deque_& operator=(deque_&& x)noexcept
     {
-        baseT::operator=(x);
+        baseT::operator=(std::move(x));
         return *this;
     }
 
@@ -281,7 +282,7 @@ public:
 
     deque_& operator=(baseT&& x)noexcept
     {
-        baseT::operator=(x);
+        baseT::operator=(std::move(x));
         return *this;
     }
 
@@ -347,6 +348,40 @@ public:
         return r;
     }
 
+    /** a view of [i:], like operator()(i) without copying items.
+     * It throws on an offset out of range, as operator()(i) does.
+     */
+    slice_<typename baseT::const_iterator> view(offset_t i)const
+    {
+        i=offset(i);
+        return slice_<typename baseT::const_iterator>(this->begin()+i, this->size()-i);
+    }
+
+    /** a view of [i:j:k], like operator()(i,j,k) without copying items.
+     * Offsets are fixed the same way. The view is invalidated as iterators are.
+     */
+    slice_<typename baseT::const_iterator> view(offset_t i, offset_t j, size_t k=1)const
+    {
+        fix_range(i,j);
+        return slice_<typename baseT::const_iterator>::of(this->begin()+i, this->begin()+j, k);
+    }
+
+    /** a writable view of [i:], throws on an offset out of range.
+     */
+    slice_<typename baseT::iterator> view(offset_t i)
+    {
+        i=offset(i);
+        return slice_<typename baseT::iterator>(this->begin()+i, this->size()-i);
+    }
+
+    /** a writable view of [i:j:k], items can be assigned through it.
+     */
+    slice_<typename baseT::iterator> view(offset_t i, offset_t j, size_t k=1)
+    {
+        fix_range(i,j);
+        return slice_<typename baseT::iterator>::of(this->begin()+i, this->begin()+j, k);
+    }
+
     /** append an item at the end.
      */
     void append(const T& x)
@@ -0,0 +1,109 @@
+#ifndef PROTON_SCAN_HEADER
+#define PROTON_SCAN_HEADER
+
+/** @file detail/scan.hpp
+ *  @brief vectorized kernels scanning chars, behind split(), strip(), count() and index() of str,
+ *  and behind ASCII case conversion, case-insensitive compare and counting tokens.
+ */
+
+#include <cstddef>
+#include <cstring>
+
+namespace proton{
+
+namespace detail{
+
+/** a set of chars to scan for, like the argument of find_first_of().
+ * Small sets are matched by SIMD compares, others by a bitmap.
+ */
+class char_set{
+public:
+    unsigned n;                 ///< the number of distinct chars
+    unsigned char chars[16];    ///< the chars, valid if n<=16
+    unsigned long long bits[4]; ///< the bitmap of the chars
+
+public:
+    char_set(const char* s, size_t len):n(0)
+    {
+        bits[0]=bits[1]=bits[2]=bits[3]=0;
+        for(size_t i=0; i<len; i++){
+            unsigned char c=(unsigned char)s[i];
+            if(has(c))
+                continue;
+            bits[c>>6]|=1ULL<<(c&63);
+            if(n<16)
+                chars[n]=c;
+            n++;
+        }
+    }
+
+    bool has(unsigned char c)const
+    {
+        return (bits[c>>6]>>(c&63))&1;
+    }
+};
+
+/** the instruction sets of scan kernels.
+ */
+enum scan_level_t{
+    scan_scalar=0,
+    scan_sse2,
+    scan_sse42,
+    scan_avx2
+};
+
+/** the first char in [b,e) in s, or e.
+ */
+const char* scan_first_of(const char* b, const char* e, const char_set& s);
+
+/** the first char in [b,e) not in s, or e.
+ */
+const char* scan_first_not_of(const char* b, const char* e, const char_set& s);
+
+/** the last char in [b,e) not in s, or NULL.
+ */
+const char* scan_last_not_of(const char* b, const char* e, const char_set& s);
+
+/** the number of c in [b,e).
+ */
+size_t scan_count(const char* b, const char* e, char c);
+
+/** the number of tokens, runs of chars not in s, starting in [b,e).
+ * Counts of adjacent ranges add up, like the items of isplit() with delimiters s.
+ * @param after_delim if the char before b is in s, or b is the beginning of the text
+ */
+size_t scan_count_tokens(const char* b, const char* e, const char_set& s, bool after_delim);
+
+/** convert ASCII letters of [b,e) to lower case, or to upper case if upper, into d.
+ * d may be b, for conversion in place.
+ * @return the first non-ASCII char of [b,e), or e; it and the chars after it are not converted
+ */
+const char* scan_ascii_case(char* d, const char* b, const char* e, bool upper);
+
+/** the first char of [a,e) differing from b in ASCII case-insensitively, or non-ASCII in either, or e.
+ */
+const char* scan_ascii_imismatch(const char* a, const char* e, const char* b);
+
+/** the first c in [b,e), or e.
+ */
+inline const char* scan_find(const char* b, const char* e, char c)
+{
+    const char* p=(const char*)std::memchr(b, c, e-b); // vectorized by libc
+    return p ? p : e;
+}
+
+/** the instruction set in use, the best one supported by the cpu by default.
+ */
+int scan_level();
+
+/** use another instruction set, for tests and benchmarks.
+ * @param level a scan_level_t, lowered to the best supported one
+ * @return the level in use
+ */
+int set_scan_level(int level);
+
+} // ns detail
+
+} // ns proton
+
+#endif // PROTON_SCAN_HEADER
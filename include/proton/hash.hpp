@@ -0,0 +1,197 @@
+#ifndef PROTON_HASH_HEADER
+#define PROTON_HASH_HEADER
+
+/** @file hash.hpp
+ *  @brief a fast seeded hash of bytes, behind std::hash of strings and sequences, and proton::hasher of tuples.
+ */
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <iterator>
+#include <type_traits>
+
+namespace proton{
+
+namespace detail{
+
+// the hash is wyhash (final version 4, public domain) by Wang Yi: 64x64->128
+// multiplies on three independent lanes of 48 bytes, so long inputs keep the
+// multipliers busy, and short ones take a couple of loads and two multiplies
+
+constexpr uint64_t hash_secret[4]={0x2d358dccaa6c78a5ull, 0x8bb84b93962eacc9ull,
+                                   0x4b33a62ed433d4a3ull, 0x4d5a2da51de1aa47ull};
+
+/** the seed of std::hash of proton types.
+ */
+constexpr uint64_t hash_seed=0x9e3779b97f4a7c15ull;
+
+inline void hash_mum(uint64_t& a, uint64_t& b)
+{
+#ifdef __SIZEOF_INT128__
+    __uint128_t r=a;
+    r*=b;
+    a=(uint64_t)r;
+    b=(uint64_t)(r>>64);
+#else
+    uint64_t ha=a>>32, hb=b>>32, la=(uint32_t)a, lb=(uint32_t)b;
+    uint64_t rh=ha*hb, rm0=ha*lb, rm1=hb*la, rl=la*lb, t=rl+(rm0<<32), c=t<rl;
+    uint64_t lo=t+(rm1<<32);
+    c+=lo<t;
+    uint64_t hi=rh+(rm0>>32)+(rm1>>32)+c;
+    a=lo;
+    b=hi;
+#endif
+}
+
+inline uint64_t hash_mix(uint64_t a, uint64_t b)
+{
+    hash_mum(a, b);
+    return a^b;
+}
+
+inline uint64_t hash_r8(const uint8_t* p)
+{
+    uint64_t v;
+    std::memcpy(&v, p, 8);
+    return v;
+}
+
+inline uint64_t hash_r4(const uint8_t* p)
+{
+    uint32_t v;
+    std::memcpy(&v, p, 4);
+    return v;
+}
+
+inline uint64_t hash_r3(const uint8_t* p, size_t k)
+{
+    return ((uint64_t)p[0]<<16) | ((uint64_t)p[k>>1]<<8) | p[k-1];
+}
+
+inline uint64_t hash_bytes64(const void* key, size_t len, uint64_t seed)
+{
+    const uint64_t* s=hash_secret;
+    const uint8_t* p=(const uint8_t*)key;
+    seed^=hash_mix(seed^s[0], s[1]);
+    uint64_t a, b;
+    if(len<=16){
+        if(len>=4){
+            a=(hash_r4(p)<<32) | hash_r4(p+((len>>3)<<2));
+            b=(hash_r4(p+len-4)<<32) | hash_r4(p+len-4-((len>>3)<<2));
+        }
+        else if(len>0){
+            a=hash_r3(p, len);
+            b=0;
+        }
+        else
+            a=b=0;
+    }
+    else{
+        size_t i=len;
+        if(i>48){
+            uint64_t see1=seed, see2=seed;
+            do{
+                seed=hash_mix(hash_r8(p)^s[1], hash_r8(p+8)^seed);
+                see1=hash_mix(hash_r8(p+16)^s[2], hash_r8(p+24)^see1);
+                see2=hash_mix(hash_r8(p+32)^s[3], hash_r8(p+40)^see2);
+                p+=48;
+                i-=48;
+            }while(i>48);
+            seed^=see1^see2;
+        }
+        while(i>16){
+            seed=hash_mix(hash_r8(p)^s[1], hash_r8(p+8)^seed);
+            i-=16;
+            p+=16;
+        }
+        a=hash_r8(p+i-16);
+        b=hash_r8(p+i-8);
+    }
+    a^=s[1];
+    b^=seed;
+    hash_mum(a, b);
+    return hash_mix(a^s[0]^len, b^s[1]);
+}
+
+// items hashed by their bytes: equal values have equal bytes, unlike floats (0.0 and -0.0)
+template<typename T>
+struct is_hash_bytes:public std::integral_constant<bool,
+    (std::is_integral<T>::value && !std::is_same<T, bool>::value) || std::is_enum<T>::value>
+{};
+
+} // ns detail
+
+/** @addtogroup seq
+ * @{
+ */
+
+/** the hash of n bytes from p.
+ * Different seeds give unrelated hashes, e.g. for hash tables that must
+ * resist chosen keys, or for several hashes of a key in bloom filters.
+ * std::hash of proton strings is hash_bytes() of their chars with the default seed.
+ */
+inline size_t hash_bytes(const void* p, size_t n, uint64_t seed=detail::hash_seed)
+{
+    return (size_t)detail::hash_bytes64(p, n, seed);
+}
+
+/** a hash of a hash h following seed, for the hash of a sequence or a tuple.
+ * The order matters: combining h1 then h2 differs from h2 then h1.
+ */
+inline size_t hash_combine(size_t seed, size_t h)
+{
+    return (size_t)detail::hash_mix((uint64_t)seed^detail::hash_secret[0], (uint64_t)h^detail::hash_secret[1]);
+}
+
+/** the default hasher of unordered_map_ and unordered_set_, and of the items of proton keys.
+ * It is std::hash, except for std::tuple (see tuple.hpp): std::hash may only be
+ * specialized for program-defined types, not for tuples of standard ones.
+ */
+template<typename T>
+struct hasher{
+    typedef size_t     result_type;
+    typedef T      argument_type;
+    size_t operator()(const T& x)const
+    {
+        return std::hash<T>()(x);
+    }
+};
+
+/** the hash of the items of [b,e) by hasher, combined in order.
+ */
+template<typename It>
+size_t hash_range(It b, It e, size_t seed=detail::hash_seed)
+{
+    typedef typename std::iterator_traits<It>::value_type T;
+    hasher<T> h;
+    for(; b!=e; ++b)
+        seed=hash_combine(seed, h(*b));
+    return seed;
+}
+
+/** the hash of n items from p, by their bytes for integers and enums,
+ * or else as hash_range() does.
+ */
+template<typename T>
+typename std::enable_if<detail::is_hash_bytes<T>::value, size_t>::type
+    hash_items(const T* p, size_t n, size_t seed=detail::hash_seed)
+{
+    return hash_bytes(p, n*sizeof(T), seed);
+}
+
+template<typename T>
+typename std::enable_if<!detail::is_hash_bytes<T>::value, size_t>::type
+    hash_items(const T* p, size_t n, size_t seed=detail::hash_seed)
+{
+    return hash_range(p, p+n, seed);
+}
+
+/**
+ * @}
+ */
+
+} // ns proton
+
+#endif // PROTON_HASH_HEADER
@@ -11,13 +11,701 @@
 #include <algorithm>
 #include <stdexcept>
 #include <limits>
+#include <memory>
+#include <string>
+#include <sstream>
+#include <cstring>
+#include <tuple>
+#include <vector>
+#include <deque>
+#include <list>
+#include <set>
+#include <map>
+#include <unordered_set>
+#include <unordered_map>
 
 #include <proton/base.hpp>
+#include <proton/pool.hpp>
+#include <proton/string_view.hpp>
+#include <proton/string.hpp>
+#include <proton/detail/scan.hpp>
 
 namespace proton{
 
+/** @defgroup io io
+ * @{
+ */
+
+/** a buffered reader of lines from a file descriptor, a file or a stream.
+ * It reads blocks into its own buffer and finds delimiters by memchr(), with
+ * no seek or tellg(). Lines are views into the buffer, so reading allocates
+ * nothing once the buffer holds the longest line; a view is valid till the
+ * next read. The buffer grows for longer lines.
+ * A stream is read through its streambuf, which is left past the chars read
+ * ahead, so don't mix reading from both.
+ */
+class line_reader{
+public:
+    typedef str_view value_type;
+
+    /** an input iterator over lines.
+     */
+    class iterator{
+    friend class line_reader;
+    public:
+        typedef std::input_iterator_tag iterator_category;
+        typedef str_view value_type;
+        typedef ptrdiff_t difference_type;
+        typedef const str_view* pointer;
+        typedef const str_view& reference;
+
+    protected:
+        line_reader* _r;
+
+    public:
+        iterator():_r(NULL)
+        {}
+
+        const str_view& operator*()const
+        {
+            return _r->_line;
+        }
+
+        const str_view* operator->()const
+        {
+            return &_r->_line;
+        }
+
+        iterator& operator++()
+        {
+            if(!_r->next(_r->_line))
+                _r=NULL;
+            return *this;
+        }
+
+        bool operator==(const iterator& x)const
+        {
+            return _r==x._r;
+        }
+
+        bool operator!=(const iterator& x)const
+        {
+            return _r!=x._r;
+        }
+    };
+    typedef iterator const_iterator;
+
+protected:
+    int _fd;                        // -1 for a stream
+    bool _own;                      // close _fd in dtor
+    std::streambuf* _sb;
+    char _delim;
+    std::unique_ptr<char[]> _buf;
+    size_t _cap;
+    const char* _p;                 // unread chars in [_p, _e)
+    const char* _e;
+    unsigned long long _offset;     // the bytes of the lines read
+    str_view _line;                 // the current line of iterators
+
+    // move the unread chars to the front, and read more after them
+    // @return false at the end of the input
+    bool fill();
+
+    void init(size_t buf_size);
+
+public:
+    static constexpr size_t default_buf_size=64*1024;
+
+    /** read from a file descriptor, left open at the end.
+     * @param fd          the file descriptor
+     * @param delim       the end of lines
+     * @param buf_size    the initial size of the buffer
+     */
+    explicit line_reader(int fd, char delim='\n', size_t buf_size=default_buf_size);
+
+    /** open and read a file.
+     * @throw std::system_error if the file can't be opened.
+     */
+    explicit line_reader(const char* path, char delim='\n', size_t buf_size=default_buf_size);
+
+    /** read from a stream.
+     */
+    explicit line_reader(std::istream& f, char delim='\n', size_t buf_size=default_buf_size);
+
+    line_reader(const line_reader&)=delete;
+    line_reader& operator=(const line_reader&)=delete;
+
+    ~line_reader();
+
+    /** read the next line.
+     * @param line the line with its delim, unless it is the last one ending without delim.
+     *             It is valid till the next read.
+     * @return false at the end of the input
+     * @throw std::system_error on errors of read().
+     */
+    bool next(str_view& line)
+    {
+        const char* s=_p;
+        while(1){
+            const char* q=detail::scan_find(s, _e, _delim);
+            if(q!=_e){
+                line=str_view(_p, q+1);
+                _offset+=q+1-_p;
+                _p=q+1;
+                return true;
+            }
+            size_t scanned=_e-_p;
+            if(!fill()){
+                if(_p==_e)
+                    return false;
+                line=str_view(_p, _e);
+                _offset+=_e-_p;
+                _p=_e;
+                return true;
+            }
+            s=_p+scanned;
+        }
+    }
+
+    /** the bytes of the lines read so far, i.e. the offset of the next line in the input.
+     */
+    unsigned long long offset()const
+    {
+        return _offset;
+    }
+
+    /** the lines left, read one by one while iterating.
+     */
+    iterator begin()
+    {
+        iterator it;
+        if(next(_line))
+            it._r=this;
+        return it;
+    }
+
+    iterator end()
+    {
+        return iterator();
+    }
+};
+
+/** read a line as readline(std::istream&) does, copied to a string.
+ * @return the line. If empty it means there is no data; otherwise a delim is
+ *         put in the end, unless the input ends without one.
+ */
+inline std::basic_string<char, std::char_traits<char>, smart_allocator<char> > readline(line_reader& r)
+{
+    str_view line;
+    if(!r.next(line))
+        return std::basic_string<char, std::char_traits<char>, smart_allocator<char> >();
+    return line;
+}
+
+/** the lines of chars in memory, as line_reader reads them.
+ * It is a forward range of views with their delims, and refers to the chars.
+ */
+class line_range{
+public:
+    typedef str_view value_type;
+
+    class iterator{
+    friend class line_range;
+    public:
+        typedef std::forward_iterator_tag iterator_category;
+        typedef str_view value_type;
+        typedef ptrdiff_t difference_type;
+        typedef const str_view* pointer;
+        typedef const str_view& reference;
+
+    protected:
+        const line_range* _r;
+        str_view _v;
+
+        void next(const char* p)
+        {
+            const char* e=_r->_e;
+            if(p==e){
+                _r=NULL;
+                _v=str_view();
+                return;
+            }
+            const char* q=detail::scan_find(p, e, _r->_delim);
+            _v=str_view(p, q==e ? e : q+1);
+        }
+
+    public:
+        iterator():_r(NULL)
+        {}
+
+        const str_view& operator*()const
+        {
+            return _v;
+        }
+
+        const str_view* operator->()const
+        {
+            return &_v;
+        }
+
+        iterator& operator++()
+        {
+            next(_v.end());
+            return *this;
+        }
+
+        iterator operator++(int)
+        {
+            iterator r=*this;
+            ++*this;
+            return r;
+        }
+
+        bool operator==(const iterator& x)const
+        {
+            return _r==x._r && _v.data()==x._v.data();
+        }
+
+        bool operator!=(const iterator& x)const
+        {
+            return !(*this==x);
+        }
+    };
+    typedef iterator const_iterator;
+
+protected:
+    const char* _b;
+    const char* _e;
+    char _delim;
+
+public:
+    line_range(const str_view& s, char delim='\n'):_b(s.data()), _e(s.data()+s.size()), _delim(delim)
+    {}
+
+    iterator begin()const
+    {
+        iterator it;
+        it._r=this;
+        it.next(_b);
+        return it;
+    }
+
+    iterator end()const
+    {
+        return iterator();
+    }
+};
+
+/** the contents of a file in memory, mapped by mmap().
+ * Regular files are mapped read-only, advised for sequential reading, so the
+ * kernel reads ahead and drops pages behind; others, like pipes, are read into
+ * a buffer till their end. Lines and fields are views into the memory, valid
+ * as long as the mapped_file, and work with split(), strip() and str_view.
+ * For input too large to map, or to keep memory flat on pipes, see line_reader.
+ */
+class mapped_file{
+protected:
+    const char* _p;
+    size_t _n;
+    bool _mapped;                   // munmap() _p in dtor
+    size_t _skip;                   // the bytes mapped before _p, to align the offset to a page
+    std::unique_ptr<char[]> _buf;   // the contents not mapped
+
+    void load(int fd, const char* name);
+    void release();
+
+public:
+    /** an empty file.
+     */
+    mapped_file():_p(NULL), _n(0), _mapped(false), _skip(0)
+    {}
+
+    /** map a file.
+     * @throw std::system_error if the file can't be opened or read.
+     */
+    explicit mapped_file(const char* path);
+
+    /** map a file descriptor from its current position, or read it till the end
+     * if it can't be mapped. Either way fd is left open at its end, and may be
+     * closed after the ctor.
+     * @throw std::system_error on errors of read().
+     */
+    explicit mapped_file(int fd);
+
+    mapped_file(mapped_file&& x)noexcept:_p(x._p), _n(x._n), _mapped(x._mapped), _skip(x._skip),
+        _buf(std::move(x._buf))
+    {
+        x._p=NULL;
+        x._n=0;
+        x._mapped=false;
+        x._skip=0;
+    }
+
+    mapped_file& operator=(mapped_file&& x)noexcept
+    {
+        if(this!=&x){
+            release();
+            _p=x._p;
+            _n=x._n;
+            _mapped=x._mapped;
+            _skip=x._skip;
+            _buf=std::move(x._buf);
+            x._p=NULL;
+            x._n=0;
+            x._mapped=false;
+            x._skip=0;
+        }
+        return *this;
+    }
+
+    mapped_file(const mapped_file&)=delete;
+    mapped_file& operator=(const mapped_file&)=delete;
+
+    ~mapped_file()
+    {
+        release();
+    }
+
+    const char* data()const
+    {
+        return _p;
+    }
+
+    size_t size()const
+    {
+        return _n;
+    }
+
+    bool empty()const
+    {
+        return _n==0;
+    }
+
+    const char* begin()const
+    {
+        return _p;
+    }
+
+    const char* end()const
+    {
+        return _p+_n;
+    }
+
+    /** whether the contents are mapped, or read into a buffer.
+     */
+    bool mapped()const
+    {
+        return _mapped;
+    }
+
+    operator str_view()const
+    {
+        return str_view(_p, _n);
+    }
+
+    /** the lines, with their delims.
+     */
+    line_range lines(char delim='\n')const
+    {
+        return line_range(*this, delim);
+    }
+
+    /** the fields of all contents lazily, as str::isplit() does.
+     */
+    split_range_<char> isplit(const str_view& delim=str_view(), int null_unite=-1)const
+    {
+        return split_range_<char>(*this, delim, null_unite);
+    }
+};
+
+/** a buffered output to a file descriptor or a stream.
+ * Writes are gathered in a large buffer and written out when it is full, by
+ * flush(), or in the dtor. Numbers are written as streams print them by default,
+ * but directly by digit tables, and strings, views, containers and tuples are
+ * printed as by their stream output, e.g. [1, 2] or {k : v}. Other types go
+ * through their stream output.
+ * Output to the same target by other means, like std::cout for fd 1, is not
+ * ordered with it until flush().
+ */
+class out_buffer{
+protected:
+    int _fd;
+    std::ostream* _os;              // the target if not NULL
+    std::unique_ptr<char[]> _buf;
+    size_t _cap;
+    size_t _n;
+
+    // write all of [p,p+n) to the target
+    void drain(const char* p, size_t n);
+
+    void init(size_t buf_size);
+
+public:
+    static constexpr size_t default_buf_size=64*1024;
+
+    /** write to a file descriptor, left open at the end.
+     * @param fd          the file descriptor, stdout by default
+     * @param buf_size    the size of the buffer
+     */
+    explicit out_buffer(int fd=1, size_t buf_size=default_buf_size);
+
+    /** write to a stream.
+     */
+    explicit out_buffer(std::ostream& o, size_t buf_size=default_buf_size);
+
+    out_buffer(const out_buffer&)=delete;
+    out_buffer& operator=(const out_buffer&)=delete;
+
+    /** flush, ignoring errors; call flush() before to get them.
+     */
+    ~out_buffer();
+
+    void append(const char* s, size_t n)
+    {
+        if(n>_cap-_n){
+            flush_buffer();
+            if(n>=_cap){
+                drain(s, n);
+                return;
+            }
+        }
+        std::memcpy(_buf.get()+_n, s, n);
+        _n+=n;
+    }
+
+    void append(const char* s)
+    {
+        append(s, std::strlen(s));
+    }
+
+    void push_back(char c)
+    {
+        if(_n==_cap)
+            flush_buffer();
+        _buf[_n++]=c;
+    }
+
+    /** write the buffered chars out, without flushing a target stream.
+     */
+    void flush_buffer()
+    {
+        size_t n=_n;
+        _n=0;
+        drain(_buf.get(), n);
+    }
+
+    /** write the buffered chars out, and flush a target stream.
+     * @throw std::system_error on errors of write().
+     */
+    void flush();
+
+    /** the chars in the buffer.
+     */
+    size_t size()const
+    {
+        return _n;
+    }
+};
+
+inline out_buffer& operator<<(out_buffer& o, char c)
+{
+    o.push_back(c);
+    return o;
+}
+
+inline out_buffer& operator<<(out_buffer& o, signed char c)
+{
+    o.push_back((char)c);
+    return o;
+}
+
+inline out_buffer& operator<<(out_buffer& o, unsigned char c)
+{
+    o.push_back((char)c);
+    return o;
+}
+
+inline out_buffer& operator<<(out_buffer& o, const char* s)
+{
+    if(s)
+        o.append(s);
+    return o;
+}
+
+/** views, and what converts to them, like small_str and symbol.
+ */
+inline out_buffer& operator<<(out_buffer& o, const str_view& s)
+{
+    o.append(s.data(), s.size());
+    return o;
+}
+
+template<typename T, typename A>
+out_buffer& operator<<(out_buffer& o, const std::basic_string<char,T,A>& s)
+{
+    o.append(s.data(), s.size());
+    return o;
+}
+
+/** numbers, as streams print them by default.
+ */
+template<typename T>
+typename std::enable_if<std::is_arithmetic<T>::value, out_buffer&>::type
+operator<<(out_buffer& o, T x)
+{
+    detail::format_arg<char,T>::write(o, x, 's');
+    return o;
+}
+
+namespace detail{
+
+template<typename R>
+void output_seq(out_buffer& o, const R& x, char open, char close)
+{
+    o.push_back(open);
+    bool first=true;
+    for(auto& t: x){
+        if(first)
+            first=false;
+        else
+            o.append(", ", 2);
+        o << t;
+    }
+    o.push_back(close);
+}
+
+template<typename M>
+void output_map(out_buffer& o, const M& x)
+{
+    o.push_back('{');
+    bool first=true;
+    for(auto& t: x){
+        if(first)
+            first=false;
+        else
+            o.append(", ", 2);
+        o << t.first;
+        o.append(" : ", 3);
+        o << t.second;
+    }
+    o.push_back('}');
+}
+
+template<size_t I, size_t N>
+struct output_tuple_to{
+    template<typename T>
+    static void output(out_buffer& o, const T& t)
+    {
+        if(I)
+            o.append(", ", 2);
+        o << std::get<I>(t);
+        output_tuple_to<I+1, N>::output(o, t);
+    }
+};
+
+template<size_t N>
+struct output_tuple_to<N, N>{
+    template<typename T>
+    static void output(out_buffer& o, const T& t)
+    {}
+};
+
+// types printed by the overloads above and below, including classes derived
+// from containers like vector_; the others are printed by streams
+template<typename T, typename A> std::true_type out_direct_test(const std::basic_string<char,T,A>*);
+template<typename T, typename A> std::true_type out_direct_test(const std::vector<T,A>*);
+template<typename T, typename A> std::true_type out_direct_test(const std::deque<T,A>*);
+template<typename T, typename A> std::true_type out_direct_test(const std::list<T,A>*);
+template<typename T, typename C, typename A> std::true_type out_direct_test(const std::set<T,C,A>*);
+template<typename T, typename H, typename E, typename A>
+std::true_type out_direct_test(const std::unordered_set<T,H,E,A>*);
+template<typename K, typename T, typename C, typename A> std::true_type out_direct_test(const std::map<K,T,C,A>*);
+template<typename K, typename T, typename H, typename E, typename A>
+std::true_type out_direct_test(const std::unordered_map<K,T,H,E,A>*);
+template<typename ...T> std::true_type out_direct_test(const std::tuple<T...>*);
+std::false_type out_direct_test(...);
+
+template<typename T>
+struct is_out_direct:public std::integral_constant<bool, std::is_arithmetic<T>::value
+    || std::is_convertible<const T&, const char*>::value || std::is_convertible<const T&, str_view>::value
+    || decltype(out_direct_test((const T*)NULL))::value>
+{};
+
+} // ns detail
+
+template<typename T, typename A>
+out_buffer& operator<<(out_buffer& o, const std::vector<T,A>& x)
+{
+    detail::output_seq(o, x, '[', ']');
+    return o;
+}
+
+template<typename T, typename A>
+out_buffer& operator<<(out_buffer& o, const std::deque<T,A>& x)
+{
+    detail::output_seq(o, x, '[', ']');
+    return o;
+}
+
+template<typename T, typename A>
+out_buffer& operator<<(out_buffer& o, const std::list<T,A>& x)
+{
+    detail::output_seq(o, x, '[', ']');
+    return o;
+}
+
+template<typename T, typename C, typename A>
+out_buffer& operator<<(out_buffer& o, const std::set<T,C,A>& x)
+{
+    detail::output_seq(o, x, '{', '}');
+    return o;
+}
+
+template<typename T, typename H, typename E, typename A>
+out_buffer& operator<<(out_buffer& o, const std::unordered_set<T,H,E,A>& x)
+{
+    detail::output_seq(o, x, '{', '}');
+    return o;
+}
+
+template<typename K, typename T, typename C, typename A>
+out_buffer& operator<<(out_buffer& o, const std::map<K,T,C,A>& x)
+{
+    detail::output_map(o, x);
+    return o;
+}
+
+template<typename K, typename T, typename H, typename E, typename A>
+out_buffer& operator<<(out_buffer& o, const std::unordered_map<K,T,H,E,A>& x)
+{
+    detail::output_map(o, x);
+    return o;
+}
+
+template<typename ...T>
+out_buffer& operator<<(out_buffer& o, const std::tuple<T...>& x)
+{
+    o.push_back('(');
+    detail::output_tuple_to<0, sizeof...(T)>::output(o, x);
+    o.push_back(')');
+    return o;
+}
+
+/** others by their stream output.
+ */
+template<typename T>
+typename std::enable_if<!detail::is_out_direct<T>::value, out_buffer&>::type
+operator<<(out_buffer& o, const T& x)
+{
+    std::ostringstream s;
+    s << x;
+    const std::string& r=s.str();
+    o.append(r.data(), r.size());
+    return o;
+}
+
 /**
- * @example io.cpp
+ * @example wc.cpp
  * @}
  */
 }
@@ -92,13 +92,13 @@ public:
 
     /** move ctor.
      */
-    map_(map_&& x)noexcept:baseT(x)
+    map_(map_&& x)noexcept:baseT(std::move(x))
     {}
 
     explicit map_(const baseT& x):baseT(x)
     {}
 
-    map_(baseT&& x)noexcept:baseT(x)
+    map_(baseT&& x)noexcept:baseT(std::move(x))
     {}
 
     /** assign.
@@ -111,7 +111,7 @@ public:
 
     map_& operator=(map_&& x)noexcept
     {
-        baseT::operator=(x);
+        baseT::operator=(std::move(x));
         return *this;
     }
 
@@ -123,7 +123,7 @@ public:
 
     map_& operator=(baseT&& x)noexcept
     {
-        baseT::operator=(x);
+        baseT::operator=(std::move(x));
         return *this;
     }
 
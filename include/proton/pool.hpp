@@ -2,6 +2,9 @@
 #define PROTON_POOL_HEADER
 #include <new>
 #include <cstddef>
+#include <cstdlib>
+#include <utility>
+#include <type_traits>
 
 #ifndef PROTON_POOL_DEBUG
 #define PROTON_POOL_DEBUG 1
@@ -25,6 +28,7 @@ class seg_pool;
 
 void mmfree(void* p);
 void* __mmdup(void* p);
+size_t mmsize(void* p);
 
 /** header of chunk, the basic of memory block.
  */
@@ -317,6 +321,19 @@ inline void* pool_dup(void *p)
         return NULL;
 }
 
+/** the usable size of a chunk from pools.
+ * It is the size of its size class, so it may be larger than requested,
+ * and a buffer may grow up to it in place.
+ */
+inline size_t pool_capacity(void *p)
+{
+    detail::chunk_header* ch=(detail::chunk_header*)(p)-1;
+    if(ch->parent)
+        return ch->parent->parent()->chunk_size();
+    else
+        return detail::mmsize((void*)ch)-sizeof(detail::chunk_header);
+}
+
 /////////////////////////////////////////////////////
 // pools
 
@@ -488,6 +505,143 @@ public:
     };
 };
 
+/////////////////////////////////////////////////////
+// thread-safe system heap
+
+namespace detail{
+
+/** header of a block from the system heap, keeping its size for sys_dup().
+ */
+union sys_header{
+    size_t size;
+    std::max_align_t align;
+};
+
+} // ns detail
+
+inline void* sys_malloc(size_t size)
+{
+    detail::sys_header* h=(detail::sys_header*)::malloc(sizeof(detail::sys_header)+size);
+    if(!h)
+        return NULL;
+    h->size=size;
+    return (void*)(h+1);
+}
+
+inline void sys_free(void* p)
+{
+    if(p)
+        ::free((detail::sys_header*)(p)-1);
+}
+
+inline void* sys_dup(void* p)
+{
+    if(p)
+        return sys_malloc(((detail::sys_header*)(p)-1)->size);
+    else
+        return NULL;
+}
+
+/** A thread-safe allocator on the system heap, with the same static interface as smart_allocator.
+ * Use it for objects released by other threads, since the pools of smart_allocator are not
+ * thread-safe.
+ */
+template<class T> class sys_allocator {
+public:
+    typedef size_t      size_type;
+    typedef ptrdiff_t   difference_type;
+    typedef T*          pointer;
+    typedef const T*    const_pointer;
+    typedef T&          reference;
+    typedef const T&    const_reference;
+    typedef T           value_type;
+    template<class U>struct rebind{
+        typedef sys_allocator<U> other;
+    };
+
+    sys_allocator()
+    {
+    }
+
+    template<class U> sys_allocator(const sys_allocator<U>&)
+    {
+    }
+
+    static size_type max_size()
+    {
+        return size_type(-1)/sizeof(T);
+    }
+
+    static pointer allocate(size_type n)
+    {
+        pointer r=(pointer)sys_malloc(sizeof(T)*n);
+        if(!r)
+            throw std::bad_alloc();
+        return r;
+    }
+
+    static pointer allocate(size_type n, const void * const)
+    {
+        return allocate(n);
+    }
+
+    static void deallocate(pointer p, size_type n)
+    {
+        sys_free(p);
+    }
+
+    /** Free a memory block not dependable on T.
+     * @see smart_allocator::confiscate()
+     */
+    static void confiscate(void* p)
+    {
+        sys_free(p);
+    }
+
+    /** Allocate a new memory block with the same size as p.
+     * @see smart_allocator::duplicate()
+     */
+    static void* duplicate(void* p)
+    {
+        return sys_dup(p);
+    }
+
+    template<class U, class... Args>
+    static void construct(U* p, Args&&... val)
+    {
+        ::new ((void*)p) U(std::forward<Args>(val)...);
+    }
+
+    static void destroy(pointer p)
+    {
+        p->~T();
+    }
+
+    bool operator==(const sys_allocator &) const
+    { return true; }
+
+    bool operator!=(const sys_allocator &) const
+    { return false; }
+};
+
+namespace detail{
+
+// true if A can free in any thread, unlike the pools of smart_allocator
+template<typename A>
+struct is_thread_safe_alloc:std::false_type{};
+
+template<typename T>
+struct is_thread_safe_alloc<sys_allocator<T> >:std::true_type{};
+
+// true if A::confiscate() frees by pool_free(), so it can free chunks of any mem_pool
+template<typename A>
+struct frees_by_pool:std::false_type{};
+
+template<typename T, typename pool_tag>
+struct frees_by_pool<smart_allocator<T, pool_tag> >:std::true_type{};
+
+} // ns detail
+
 /**
  * @}
  */
@@ -7,6 +7,8 @@
 
 #include <memory>
 #include <utility>
+#include <iterator>
+#include <algorithm>
 #include <tuple>
 #include <type_traits>
 #include <stdexcept>
@@ -113,6 +115,186 @@ public:
 
 };
 
+/** a thread-safe refc_t.
+ * Use it with a thread-safe allocator, e.g. sys_allocator, for refs shared across threads.
+ */
+class arefc_t {
+public:
+    typedef int support_atomic;
+
+private:
+    std::atomic<long> __r;
+
+public:
+    arefc_t():__r(0)
+    {}
+
+    arefc_t(const arefc_t& r):__r(0)
+    {}
+
+    arefc_t& operator=(const arefc_t& r)
+    {
+        return *this;
+    }
+
+    void enter()
+    {
+        __r.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    long release()
+    {
+        return __r.fetch_sub(1, std::memory_order_acq_rel)-1;
+    }
+
+    long count() const
+    {
+        return __r.load(std::memory_order_acquire);
+    }
+
+    static constexpr long weak_count()
+    {
+        return 0;
+    }
+};
+
+/** a refc_t caching the hash of the object.
+ * key_hash, subkey_hash and std::hash of refs compute the hash once and keep it here, and
+ * operator== of refs rejects objects with different cached hashes before comparing them.
+ * Note: the hashed part of an object must not change after it is hashed.
+ * @param refcT the counting policy, e.g. refc_t, wrefc_t.
+ */
+template<typename refcT=refc_t>
+class hrefc_t:public refcT {
+public:
+    typedef int support_hash;
+
+private:
+    const void* __hf; // the hash function of __h, NULL: no cached hash
+    size_t __h;
+
+public:
+    hrefc_t():__hf(NULL), __h(0)
+    {}
+
+    hrefc_t(const hrefc_t& r):refcT(r), __hf(NULL), __h(0)
+    {}
+
+    hrefc_t& operator=(const hrefc_t& r)
+    {
+        return *this;
+    }
+
+    /** get the hash by hf.
+     * @return false if it is not computed by hf yet
+     */
+    bool get_hash(const void* hf, size_t& h)const
+    {
+        if(__hf!=hf)
+            return false;
+        h=__h;
+        return true;
+    }
+
+    void set_hash(const void* hf, size_t h)
+    {
+        __hf=hf;
+        __h=h;
+    }
+
+    /** true if both hashes are computed by the same function and differ.
+     */
+    bool hash_differs(const hrefc_t& x)const
+    {
+        return __hf!=NULL && __hf==x.__hf && __h!=x.__h;
+    }
+};
+
+// true if a refc_t caches hashes, see hrefc_t.
+template<typename R, typename X=void>
+struct is_hashed:std::false_type{};
+
+template<typename R>
+struct is_hashed<R, typename std::enable_if<
+        std::is_same<typename R::support_hash, int>::value
+    >::type>:std::true_type{};
+
+// the address of id identifies a hash function H
+template<typename H>
+struct hash_id{
+    static const char id;
+};
+
+template<typename H>
+const char hash_id<H>::id=0;
+
+template<typename R1, typename R2>
+typename std::enable_if<is_hashed<R1>::value && std::is_same<R1,R2>::value, bool>::type
+    hash_differs(const R1* x, const R2* y)
+{
+    return x->hash_differs(*y);
+}
+
+template<typename R1, typename R2>
+typename std::enable_if<!(is_hashed<R1>::value && std::is_same<R1,R2>::value), bool>::type
+    hash_differs(const R1* x, const R2* y)
+{
+    return false;
+}
+
+// true if a refc_t defers the destruction of objects, see drefc_t in <proton/deferred.hpp>.
+template<typename R, typename X=void>
+struct is_deferred:std::false_type{};
+
+template<typename R>
+struct is_deferred<R, typename std::enable_if<
+        std::is_same<typename R::support_deferred, int>::value
+    >::type>:std::true_type{};
+
+// true if a refc_t counts atomically, see arefc_t.
+template<typename R, typename X=void>
+struct is_atomic_refc:std::false_type{};
+
+template<typename R>
+struct is_atomic_refc<R, typename std::enable_if<
+        std::is_same<typename R::support_atomic, int>::value
+    >::type>:std::true_type{};
+
+// true if a refc_t supports the cycle collector, see crefc_t in <proton/cycle.hpp>.
+template<typename R, typename X=void>
+struct is_collected:std::false_type{};
+
+template<typename R>
+struct is_collected<R, typename std::enable_if<
+        std::is_same<typename R::support_cycle, int>::value
+    >::type>:std::true_type{};
+
+// in-place helpers for rvalue operators of ref_, falling back to a move-assign.
+
+template<typename O, typename X>
+auto inplace_add(O& o, const X& x, int) -> decltype(void(o+=x))
+{
+    o+=x;
+}
+
+template<typename O, typename X>
+void inplace_add(O& o, const X& x, long)
+{
+    o=o+x;
+}
+
+template<typename O, typename X>
+auto inplace_mul(O& o, const X& x, int) -> decltype(void(o*=x))
+{
+    o*=x;
+}
+
+template<typename O, typename X>
+void inplace_mul(O& o, const X& x, long)
+{
+    o=o*x;
+}
+
 } // ns detail
 
 /** @addtogroup ref
@@ -135,7 +317,8 @@ extern init_alloc_none none; ///< explicitly demand to construct an empty object
 enum ref_flags{
     ref_not_use_output=0x1,
     ref_immutable=0x2,
-    ref_not_cast_obj=0x4
+    ref_not_cast_obj=0x4,
+    ref_cow=0x8 ///< copy on write: a non-const access clones a shared object first.
 };
 
 template<typename T>
@@ -143,10 +326,49 @@ struct ref_traits{
     static constexpr unsigned long long flag=0;
 };
 
+/** traits for copy-on-write refs, see cowref_.
+ */
+template<typename T>
+struct cow_traits{
+    static constexpr unsigned long long flag=ref_cow;
+};
+
 template<typename objT, typename allocator=smart_allocator<objT>,
 		typename traits=ref_traits<objT>, typename refcT=detail::refc_t >
 struct ref_;
 
+namespace detail{
+
+// the ref type of T: T itself if it is a ref_ type, otherwise ref_<T>.
+template<typename T, typename X=void>
+struct ref_of{
+    typedef ref_<T> type;
+};
+
+template<typename T>
+struct ref_of<T, typename std::enable_if<
+        std::is_class<typename T::proton_ref_self_t>::value
+    >::type>{
+    typedef T type;
+};
+
+} // ns detail
+
+template<typename T, typename ...argT>
+typename detail::ref_of<T>::type allocate_ref(mem_pool& pool, argT&& ...a);
+
+class cc_visitor;
+
+template<typename objT, typename allocator, typename traits, typename refcT>
+class uref_;
+
+namespace detail{
+
+template<typename H, typename O, typename A, typename T, typename R>
+typename std::enable_if<is_hashed<R>::value, size_t>::type cached_hash(const ref_<O,A,T,R>& x);
+
+} // ns detail
+
 /** declare copy_to().
  * For object classes which need to support copy().
  */
@@ -165,6 +387,105 @@ struct ref_;
         new (p) type(*this);\
     }
 
+/** the runtime type tag of a class declared by PROTON_TYPE_ROOT() or PROTON_TYPE_DERIVED().
+ * Each tag keeps the tags of all its tagged bases in display[], indexed by depth, so checking
+ * whether an object is a given class is a single compare, whatever the depth is.
+ */
+struct type_tag{
+    size_t depth;
+    const type_tag* const* display; ///< display[i]: the tagged base at depth i, display[depth]==this
+};
+
+namespace detail{
+
+template<size_t n>
+struct type_node:type_tag{
+    const type_tag* a[n+1];
+
+    type_node(const type_tag* parent)
+    {
+        for(size_t i=0; i<n; i++)
+            a[i]=parent->display[i];
+        a[n]=this;
+        depth=n;
+        display=a;
+    }
+};
+
+template<typename C>
+const type_tag* parent_tag(std::true_type)
+{
+    return NULL;
+}
+
+template<typename C>
+const type_tag* parent_tag(std::false_type);
+
+// true if C declares its own tag, not just inherits one
+template<typename C, typename X=void>
+struct has_type_tag:std::false_type{};
+
+template<typename C>
+struct has_type_tag<C, typename std::enable_if<
+        std::is_same<typename C::proton_type_self_t, C>::value
+    >::type>:std::true_type{};
+
+} // ns detail
+
+/** get the type tag of a class declared by PROTON_TYPE_ROOT() or PROTON_TYPE_DERIVED().
+ */
+template<typename C>
+const type_tag* type_tag_of()
+{
+    static_assert(detail::has_type_tag<C>::value, "C must be declared by PROTON_TYPE_ROOT() or PROTON_TYPE_DERIVED()");
+    static const detail::type_node<C::proton_type_depth> t(
+        detail::parent_tag<typename C::proton_type_base_t>(
+            std::integral_constant<bool, C::proton_type_depth==0>()));
+    return &t;
+}
+
+namespace detail{
+
+template<typename C>
+const type_tag* parent_tag(std::false_type)
+{
+    return type_tag_of<C>();
+}
+
+// true if the object tagged t is a C
+inline bool type_tag_is(const type_tag* t, const type_tag* c)
+{
+    return t->depth>=c->depth && t->display[c->depth]==c;
+}
+
+} // ns detail
+
+/** declare the root class of a tagged hierarchy.
+ * Then cast<>() and visit() on refs of classes in this hierarchy check the type by
+ * the tags in O(1), instead of dynamic_cast. The root must be polymorphic, and the
+ * hierarchy must use non-virtual single inheritance between tagged classes.
+ */
+#define PROTON_TYPE_ROOT(type)\
+    typedef type proton_type_self_t;\
+    typedef void proton_type_base_t;\
+    static constexpr size_t proton_type_depth=0;\
+    virtual const proton::type_tag* proton_type_tag()const\
+    {\
+        return proton::type_tag_of<type>();\
+    }
+
+/** declare a class derived from base in a tagged hierarchy.
+ * Classes without it are still cast by dynamic_cast.
+ */
+#define PROTON_TYPE_DERIVED(type, base)\
+    typedef type proton_type_self_t;\
+    typedef base proton_type_base_t;\
+    static constexpr size_t proton_type_depth=base::proton_type_depth+1;\
+    virtual const proton::type_tag* proton_type_tag()const\
+    {\
+        return proton::type_tag_of<type>();\
+    }
+
 /** Generate a copy of object.
  * Note: the alloc_t of refT must support duplicate() like smart_allocator.
  * @param x a ref to an obj supporting the method: void copy_to(void* new_addr)const.
@@ -185,7 +506,14 @@ template<typename O, typename A, typename T, typename R> ref_<O,A,T,R> copy(cons
         throw std::bad_alloc();
     new (p) refc_t();
     typename refT::obj_t* q=(typename refT::obj_t *)(p+1);
-    x->copy_to((void*)q);
+    try{
+        x->copy_to((void*)q);
+    }
+    catch(...){
+        alloc_t::confiscate(p);
+        throw;
+    }
+    refT::bind(p,q);
     return refT(alloc_inner,p,q);
 }
 
@@ -202,8 +530,45 @@ template<typename O, typename A, typename T, typename R> long ref_count(const re
         return 0;
 }
 
+namespace detail{
+
+// true if a From* can be downcast to To* by the type tags, where both are tagged
+template<typename To, typename From>
+struct tag_castable:std::integral_constant<bool,
+        has_type_tag<To>::value && has_type_tag<From>::value && std::is_base_of<From, To>::value
+    >{};
+
+template<typename To, typename From>
+typename std::enable_if<tag_castable<To,From>::value, To*>::type fast_cast(From* p)
+{
+    if(type_tag_is(p->proton_type_tag(), type_tag_of<To>()))
+        return static_cast<To*>(p);
+    return NULL;
+}
+
+template<typename To, typename From>
+typename std::enable_if<!tag_castable<To,From>::value, To*>::type fast_cast(From* p)
+{
+    return dynamic_cast<To*>(p);
+}
+
+// cast, or return none on failure
+template<typename C, typename O2, typename A2, typename T2, typename R2 >
+C try_cast(const ref_<O2,A2,T2,R2>& x)
+{
+    typedef typename C::obj_t target_t;
+    target_t* p=fast_cast<target_t>(x._p);
+    if(p)
+        return C(alloc_inner, x._rp, p);
+    return C();
+}
+
+} // ns detail
+
 /** cast from a ref type to another.
  * if casting fails, throw std::bad_cast().
+ * Down casting to a class declared by PROTON_TYPE_ROOT() or PROTON_TYPE_DERIVED() checks the
+ * type tags, otherwise dynamic_cast is used.
  * @param x the original ref
  * @return the casted one
  */
@@ -213,12 +578,61 @@ C cast(const ref_<O2,A2,T2,R2>& x)
     if(x==none)
         return C();
     typedef typename C::obj_t target_t;
-    target_t* p=dynamic_cast<target_t*>(x._p);
+    target_t* p=detail::fast_cast<target_t>(x._p);
     if(p)
         return C(alloc_inner, x._rp, p);
     throw std::bad_cast();
 }
 
+/** test if the object is a C::obj_t, like isinstance() in python.
+ * @param x the ref to test
+ * @return false if x is none or not a C::obj_t
+ */
+template<typename C, typename O2, typename A2, typename T2, typename R2 >
+bool isinstance(const ref_<O2,A2,T2,R2>& x)
+{
+    if(x==none)
+        return false;
+    return detail::fast_cast<typename C::obj_t>(x._p)!=NULL;
+}
+
+namespace detail{
+
+template<typename ...T>
+struct type_list{};
+
+template<typename refT, typename F>
+auto visit_item(type_list<>, const refT& x, F&& f) -> decltype(f(x))
+{
+    return f(x);
+}
+
+template<typename C, typename ...T, typename refT, typename F>
+auto visit_item(type_list<C, T...>, const refT& x, F&& f) -> decltype(f(x))
+{
+    C c=try_cast<C>(x);
+    if(c!=none)
+        return f(c);
+    return visit_item(type_list<T...>(), x, std::forward<F>(f));
+}
+
+} // ns detail
+
+/** dispatch a ref to a closed set of derived types.
+ * f is called with the ref casted to the first matched type in C..., like catch clauses,
+ * so list derived types before their bases. If none matches, f gets x itself.
+ * For a tagged hierarchy, the tag of x is checked once per candidate without dynamic_cast.
+ * @param x a ref, must not be none
+ * @param f a callable accepting each of C..., and refT, with the same return type,
+ *          e.g. a generic lambda or a struct overloading operator().
+ * @return what f returns
+ */
+template<typename ...C, typename refT, typename F>
+auto visit(const refT& x, F&& f) -> decltype(f(x))
+{
+    return detail::visit_item(detail::type_list<C...>(), x, std::forward<F>(f));
+}
+
 /** The core reference support template.
  * @param allocator It must support confiscate(), and allocator::allocate() must be static.
  * @see smart_allocator in <proton/pool.hpp>
@@ -231,12 +645,26 @@ template<typename O, typename A, typename T, typename R>
     friend long ref_count(const ref_<O,A,T,R>& x);
 template<typename C, typename O2, typename A2, typename T2, typename R >
     friend C cast(const ref_<O2,A2,T2, R>& x);
+template<typename C, typename O2, typename A2, typename T2, typename R >
+    friend bool isinstance(const ref_<O2,A2,T2, R>& x);
+template<typename C, typename O2, typename A2, typename T2, typename R >
+    friend C detail::try_cast(const ref_<O2,A2,T2, R>& x);
+template<typename H, typename O, typename A, typename T, typename R>
+    friend typename std::enable_if<detail::is_hashed<R>::value, size_t>::type
+        detail::cached_hash(const ref_<O,A,T,R>& x);
 template<typename T>
 	friend class weak_;
 template<typename T>
 	friend class para_;
+template<typename T>
+	friend class atomic_ref_;
+    friend class cc_visitor;
 template<typename O, typename A, typename T, typename R>
 	friend class ref_;
+template<typename O, typename A, typename T, typename R>
+	friend class uref_;
+template<typename T, typename ...argT>
+    friend typename detail::ref_of<T>::type allocate_ref(mem_pool& pool, argT&& ...a);
 
 public:
     typedef ref_ proton_ref_self_t;
@@ -268,16 +696,79 @@ protected:
     {
         if(_rp){
             if(!_rp->release()){
-                _p->~objT();
-                if(!_rp->weak_count()){
-                	alloc_t::confiscate(_rp);
-                }
+                dispose(_rp, _p);
+            }
+            else{
+                decreased(_rp);
             }
         	_rp=NULL;
             _p=NULL;
         }
     }
 
+    /** destroy the object and free its chunk.
+     */
+    static void destroy(void* rp, void* p)
+    {
+        ((objT*)p)->~objT();
+        if(!((refc_t*)rp)->weak_count()){
+            alloc_t::confiscate(rp);
+        }
+    }
+
+    static void destruct(void* p)
+    {
+        ((objT*)p)->~objT();
+    }
+
+    static void trace(void* p, cc_visitor& v)
+    {
+        ((const objT*)p)->trace(v);
+    }
+
+    template<typename R>
+    static typename std::enable_if<
+            !detail::is_deferred<R>::value && !detail::is_collected<R>::value
+        >::type dispose(R* rp, objT* p)
+    {
+        destroy(rp, p);
+    }
+
+    template<typename R>
+    static typename std::enable_if<detail::is_collected<R>::value>::type dispose(R* rp, objT* p)
+    {
+        rp->dispose();
+    }
+
+    template<typename R>
+    static typename std::enable_if<!detail::is_collected<R>::value>::type decreased(R* rp)
+    {}
+
+    template<typename R>
+    static typename std::enable_if<detail::is_collected<R>::value>::type decreased(R* rp)
+    {
+        rp->decreased();
+    }
+
+    /** tell the refc_t about a new object.
+     */
+    template<typename R>
+    static typename std::enable_if<!detail::is_collected<R>::value>::type bind(R* rp, objT* p)
+    {}
+
+    template<typename R>
+    static typename std::enable_if<detail::is_collected<R>::value>::type bind(R* rp, objT* p)
+    {
+        rp->bind(p, &trace, &destruct, &alloc_t::confiscate);
+    }
+
+    template<typename R>
+    static typename std::enable_if<detail::is_deferred<R>::value>::type dispose(R* rp, objT* p)
+    {
+        // objects of thread-safe refs may be destroyed by a reclaimer in another thread
+        rp->retire(p, &destroy, detail::is_atomic_refc<R>::value && detail::is_thread_safe_alloc<alloc_t>::value);
+    }
+
     void swap(ref_& r)
     {
     	refc_t* t_rp=r._rp;
@@ -290,6 +781,46 @@ protected:
     	_p=t_p;
     }
 
+    /** construct the refc_t and the obj_t in chunk p, and refer to them.
+     * p is freed if the ctor of obj_t throws.
+     */
+    template<typename ...argT> void construct(void* p, argT&& ...a)
+    {
+        if(!p)
+            throw std::bad_alloc();
+        ref_obj_t* q=(ref_obj_t*)p;
+        new (&(q->r)) refc_t();
+        try{
+            new (&(q->o)) obj_t(std::forward<argT>(a)...);
+        }
+        catch(...){
+            alloc_t::confiscate(p);
+            throw;
+        }
+        _p=&(q->o);
+        enter(&(q->r));
+        bind(_rp, _p);
+    }
+
+    /** true if this is the only handle to the object, so it can be changed in place.
+     */
+    bool unique()const
+    {
+        return _rp && _rp->count()==1 && !_rp->weak_count();
+    }
+
+    /** drop the hash cached by hrefc_t, after the object is changed in place.
+     */
+    template<typename R>
+    static typename std::enable_if<detail::is_hashed<R>::value>::type forget_hash(R* rp)
+    {
+        rp->set_hash(NULL, 0);
+    }
+
+    template<typename R>
+    static typename std::enable_if<!detail::is_hashed<R>::value>::type forget_hash(R* rp)
+    {}
+
 protected:
     // inner use
     ref_(init_alloc_inner, refc_t* rp, objT* p):_rp(rp), _p(p)
@@ -299,6 +830,15 @@ protected:
             _rp->enter();
     }
 
+    // inner use, construct in a chunk of the given pool
+    template<typename ...argT> ref_(init_alloc_inner, mem_pool& pool, argT&& ...a)
+    {
+        static_assert(detail::frees_by_pool<alloc_t>::value,
+                      "allocate_ref() needs an allocator freeing by pool_free(), like smart_allocator");
+        PROTON_REF_LOG(9,"alloc pool ctor");
+        construct(pool.malloc(sizeof(ref_obj_t)), std::forward<argT>(a)...);
+    }
+
 public:
     /** default ctor.
      * Doesn't refer to any object.
@@ -319,22 +859,14 @@ public:
     template<typename ...argT> explicit ref_(init_alloc, argT&& ...a)
     {
         PROTON_REF_LOG(9,"alloc fwd ctor");
-        ref_obj_t* p=real_alloc::allocate(1);
-        if(p){
-            new (&(p->r)) refc_t();
-            new (&p->o) obj_t(a...); // [FIXME] how about exceptions?
-            _p=&(p->o);
-            enter(&(p->r));
-        }
-        else
-            throw std::bad_alloc();
+        construct(real_alloc::allocate(1), std::forward<argT>(a)...);
     }
 
     /** implicit forwarding ctor.
      * Construct an obj_t using give args.
      * Note: don't conflict with copy ctors. Use the explicit fwd ctor in that case.
      */
-    template<typename ...argT> explicit ref_(argT&& ...a):ref_(alloc, a...)
+    template<typename ...argT> explicit ref_(argT&& ...a):ref_(alloc, std::forward<argT>(a)...)
     {}
 
 	template<typename=typename std::enable_if<
@@ -348,7 +880,7 @@ public:
             !(traits::flag & ref_not_cast_obj)
         >::type
         >
-        ref_(obj_t&& a):ref_(alloc, a)
+        ref_(obj_t&& a):ref_(alloc, std::move(a))
     {}
 
     /** initializer_list forwarding ctor.
@@ -357,15 +889,7 @@ public:
     template<typename T> ref_(init_alloc, std::initializer_list<T> a)
     {
         PROTON_REF_LOG(9,"alloc initializer_list fwd ctor");
-        ref_obj_t* p=real_alloc::allocate(1);
-        if(p){
-            new (&(p->r)) refc_t();
-            new (&p->o) obj_t(a);
-            _p=&(p->o);
-            enter(&(p->r));
-        }
-        else
-            throw std::bad_alloc();
+        construct(real_alloc::allocate(1), a);
     }
 
     /** implicit initializer_list forwarding ctor.
@@ -403,6 +927,30 @@ public:
         r._p=NULL;
     }
 
+    /** take the object of a uref_ in place, see <proton/uref.hpp>.
+     * The refc_t of the chunk is constructed now, so no reallocation.
+     */
+    template<typename O, typename A, typename T, typename=typename std::enable_if<
+            std::is_base_of<objT, O>::value
+            && std::is_same<typename A::template rebind<objT>::other, allocator>::value
+        >::type>
+    ref_(uref_<O,A,T,refcT>&& x)
+    {
+        PROTON_REF_LOG(9,"uref_ ctor");
+        if(x._p){
+            refc_t* rp=(refc_t*)uref_<O,A,T,refcT>::chunk(x._p);
+            new (rp) refc_t();
+            _p=static_cast<objT*>(x._p);
+            x._p=NULL;
+            enter(rp);
+            bind(_rp, _p);
+        }
+        else{
+            _rp=NULL;
+            _p=NULL;
+        }
+    }
+
     /** assign operator.
      */
     ref_& operator=(const ref_& r)
@@ -447,19 +995,8 @@ public:
     ref_& operator=(T a)
     {
         PROTON_REF_LOG(9,"assign argument");
-        ref_obj_t* p=real_alloc::allocate(1);
-        if(!p)
-            throw std::bad_alloc();
-        {
-            new (&(p->r)) refc_t();
-            new (&p->o) obj_t(a);
-
-            ref_ r(none);
-            swap(r);
-
-            enter(&(p->r));
-            _p=&(p->o);
-        }
+        ref_ r(alloc, a);
+        swap(r);
         return *this;
     }
 
@@ -558,9 +1095,38 @@ public:
 
     objT& __o()
     {
+        detach(std::integral_constant<bool, (traits::flag & ref_cow)!=0>());
         return *_p;
     }
 
+protected:
+    void detach(std::false_type)
+    {}
+
+    /** clone a shared object before writing it, including one seen by weak refs.
+     */
+    void detach(std::true_type)
+    {
+        if(_rp && !unique()){
+            ref_ r(clone(*this, 0));
+            swap(r);
+        }
+    }
+
+    template<typename R>
+    static auto clone(const R& x, int) -> decltype(x->copy_to(NULL), R())
+    {
+        return copy(x);
+    }
+
+    template<typename R>
+    static R clone(const R& x, long)
+    {
+        return R(alloc, *x._p);
+    }
+
+public:
+
 
     objT& operator *()
     {
@@ -613,6 +1179,8 @@ public:
             return true;
         if(*this==none || x==none)
             return false;
+        if(detail::hash_differs(_rp, x._rp))
+            return false;
         return __o() == x.__o();
     }
 
@@ -684,7 +1252,7 @@ public:
     /** general operator() const for refs.
      * Need to implement obj_t() const.
      */
-    template<typename ...T> auto operator()(T&& ...x)const -> decltype((*_p)(x...))
+    template<typename ...T> auto operator()(T&& ...x)const -> decltype(std::declval<const objT&>()(x...))
     {
         PROTON_THROW_IF(*this==none, "nullptr for ()");
         return __o()(x...);
@@ -702,7 +1270,7 @@ public:
     /** general operator[] const for refs.
      * Need to implement obj_t[] const.
      */
-    template<typename T> auto operator[](T&& x)const -> decltype((*_p)[x])
+    template<typename T> auto operator[](T&& x)const -> decltype(std::declval<const objT&>()[x])
     {
         PROTON_THROW_IF(*this==none, "nullptr for []");
         return __o()[x];
@@ -718,21 +1286,32 @@ public:
     }
 
     /** ref_ + ref_
-     * [TODO] using move ctor
      */
     template<typename T,
         typename=typename std::enable_if<std::is_same<T, ref_>::value>::type
         >
-    ref_ operator+(const T& x)const
+    ref_ operator+(const T& x)const&
     {
         PROTON_THROW_IF(x==none || *this==none,"want to add null values");
-        refc_t* p=(refc_t*)alloc_t::duplicate(_rp);
-        if(!p)
-            throw std::bad_alloc();
-        new (p) refc_t();
-        obj_t* q=(obj_t *)(p+1);
-        new (q) obj_t(__o()+x.__o());
-        return ref_(alloc_inner,p,q);
+        ref_ r;
+        r.construct(alloc_t::duplicate(_rp), __o()+x.__o());
+        return r;
+    }
+
+    /** ref_&& + ref_
+     * Append to the object in place if this temporary is its only ref.
+     */
+    template<typename T,
+        typename=typename std::enable_if<std::is_same<T, ref_>::value>::type
+        >
+    ref_ operator+(const T& x)&&
+    {
+        if(!unique())
+            return static_cast<const ref_&>(*this)+x;
+        PROTON_THROW_IF(x==none,"want to add null values");
+        detail::inplace_add(__o(), x.__o(), 0);
+        forget_hash(_rp);
+        return std::move(*this);
     }
 
     /** ref_ + pod
@@ -740,16 +1319,26 @@ public:
     template<typename T,
         typename=typename std::enable_if<std::is_pod<T>::value>::type
         >
-    ref_ operator+(T x)const
+    ref_ operator+(T x)const&
     {
         PROTON_THROW_IF(*this==none,"want to add null values");
-        refc_t* p=(refc_t*)alloc_t::duplicate(_rp);
-        if(!p)
-            throw std::bad_alloc();
-        new (p) refc_t();
-        obj_t* q=(obj_t *)(p+1);
-        new (q) obj_t(__o()+x);
-        return ref_(alloc_inner,p,q);
+        ref_ r;
+        r.construct(alloc_t::duplicate(_rp), __o()+x);
+        return r;
+    }
+
+    /** ref_&& + pod
+     */
+    template<typename T,
+        typename=typename std::enable_if<std::is_pod<T>::value>::type
+        >
+    ref_ operator+(T x)&&
+    {
+        if(!unique())
+            return static_cast<const ref_&>(*this)+x;
+        detail::inplace_add(__o(), x, 0);
+        forget_hash(_rp);
+        return std::move(*this);
     }
 
     /** ref_ * pod
@@ -757,31 +1346,50 @@ public:
     template<typename T,
         typename=typename std::enable_if<std::is_pod<T>::value>::type
         >
-    ref_ operator*(T x)const
+    ref_ operator*(T x)const&
     {
         PROTON_THROW_IF(*this==none,"want to * null values");
-        refc_t* p=(refc_t*)alloc_t::duplicate(_rp);
-        if(!p)
-            throw std::bad_alloc();
-        new (p) refc_t();
-        obj_t* q=(obj_t *)(p+1);
-        new (q) obj_t(__o()*x);
-        return ref_(alloc_inner,p,q);
+        ref_ r;
+        r.construct(alloc_t::duplicate(_rp), __o()*x);
+        return r;
+    }
+
+    /** ref_&& * pod
+     */
+    template<typename T,
+        typename=typename std::enable_if<std::is_pod<T>::value>::type
+        >
+    ref_ operator*(T x)&&
+    {
+        if(!unique())
+            return static_cast<const ref_&>(*this)*x;
+        detail::inplace_mul(__o(), x, 0);
+        forget_hash(_rp);
+        return std::move(*this);
     }
 
     /** ref_ % other
      */
     template<typename T>
-    ref_ operator%(const T& x)const
+    ref_ operator%(const T& x)const&
     {
         PROTON_THROW_IF(*this==none, "want to % null values");
-        refc_t* p=(refc_t*)alloc_t::duplicate(_rp);
-        if(!p)
-            throw std::bad_alloc();
-        new (p) refc_t();
-        obj_t* q=(obj_t *)(p+1);
-        new (q) obj_t(__o() % x);
-        return ref_(alloc_inner,p,q);
+        ref_ r;
+        r.construct(alloc_t::duplicate(_rp), __o() % x);
+        return r;
+    }
+
+    /** ref_&& % other
+     * Reuse the chunk of the temporary for the result.
+     */
+    template<typename T>
+    ref_ operator%(const T& x)&&
+    {
+        if(!unique())
+            return static_cast<const ref_&>(*this) % x;
+        __o()=__o() % x;
+        forget_hash(_rp);
+        return std::move(*this);
     }
 
     /** ref_ << other
@@ -833,19 +1441,8 @@ public:
     {
         PROTON_THROW_IF(x==none || *this==none,"want to add null values");
 
-        ref_obj_t* p=real_alloc::allocate(1);
-        if(!p)
-            throw std::bad_alloc();
-        {
-            new (&(p->r)) refc_t();
-            new (&p->o) obj_t(__o()+x.__o());
-
-            ref_ r(none);
-            swap(r);
-
-            enter(&(p->r));
-            _p=&(p->o);
-        }
+        ref_ r(alloc, __o()+x.__o());
+        swap(r);
         return *this;
     }
 
@@ -856,19 +1453,8 @@ public:
     {
         PROTON_THROW_IF(*this==none,"want to add null values");
 
-        ref_obj_t* p=real_alloc::allocate(1);
-        if(!p)
-            throw std::bad_alloc();
-        {
-            new (&(p->r)) refc_t();
-            new (&p->o) obj_t(__o()+x);
-
-            ref_ r(none);
-            swap(r);
-
-            enter(&(p->r));
-            _p=&(p->o);
-        }
+        ref_ r(alloc, __o()+x);
+        swap(r);
         return *this;
     }
 
@@ -891,19 +1477,8 @@ public:
     {
         PROTON_THROW_IF(*this==none,"want to *= null values");
 
-        ref_obj_t* p=real_alloc::allocate(1);
-        if(!p)
-            throw std::bad_alloc();
-        {
-            new (&(p->r)) refc_t();
-            new (&p->o) obj_t(__o()*x);
-
-            ref_ r(none);
-            swap(r);
-
-            enter(&(p->r));
-            _p=&(p->o);
-        }
+        ref_ r(alloc, __o()*x);
+        swap(r);
         return *this;
     }
 
@@ -953,6 +1528,95 @@ void reset(ref_<O,A,T,R>& x)
     x=none;
 }
 
+/** construct an object and a ref to it, in one chunk of the default pool.
+ * Args are perfectly forwarded to the ctor of the object.
+ * @param T the object type, or a ref_ type
+ * @return the new ref
+ */
+template<typename T, typename ...argT>
+typename detail::ref_of<T>::type make_ref(argT&& ...a)
+{
+    return typename detail::ref_of<T>::type(alloc, std::forward<argT>(a)...);
+}
+
+/** construct an object and a ref to it, in one chunk of a given pool.
+ * The pool must outlive the object. The ref type must free by pool_free(), as refs
+ * with smart_allocator do; refs with sys_allocator, like aref_, can't be allocated here.
+ * @param T the object type, or a ref_ type
+ * @param pool the pool as an arena
+ * @return the new ref
+ */
+template<typename T, typename ...argT>
+typename detail::ref_of<T>::type allocate_ref(mem_pool& pool, argT&& ...a)
+{
+    return typename detail::ref_of<T>::type(alloc_inner, pool, std::forward<argT>(a)...);
+}
+
+namespace detail{
+
+template<typename O, typename A, typename T, typename R>
+const O& concat_item(const ref_<O,A,T,R>& x)
+{
+    PROTON_THROW_IF(x==none, "want to concat null values");
+    return x.__o();
+}
+
+template<typename X>
+const X& concat_item(const X& x)
+{
+    return x;
+}
+
+inline size_t concat_size()
+{
+    return 0;
+}
+
+template<typename X, typename ...Y>
+size_t concat_size(const X& x, const Y& ...y)
+{
+    return concat_item(x).size()+concat_size(y...);
+}
+
+template<typename O, typename I>
+auto concat_range(O& o, const I& i, int) -> decltype(void(o.append(i.begin(), i.end())))
+{
+    o.append(i.begin(), i.end());
+}
+
+template<typename O, typename I>
+void concat_range(O& o, const I& i, long)
+{
+    std::copy(i.begin(), i.end(), std::back_inserter(o));
+}
+
+template<typename O>
+void concat_append(O& o)
+{}
+
+template<typename O, typename X, typename ...Y>
+void concat_append(O& o, const X& x, const Y& ...y)
+{
+    concat_range(o, concat_item(x), 0);
+    concat_append(o, y...);
+}
+
+} // ns detail
+
+/** concatenate sequences (strings, vectors) into a new ref, sizing its object once.
+ * @param x the first ref
+ * @param y other refs of the same type, or plain sequences
+ * @return a new ref to x+y[0]+y[1]...
+ */
+template<typename O, typename A, typename T, typename R, typename ...X>
+ref_<O,A,T,R> concat(const ref_<O,A,T,R>& x, const X& ...y)
+{
+    ref_<O,A,T,R> r(alloc);
+    r->reserve(detail::concat_size(x, y...));
+    detail::concat_append(r.__o(), x, y...);
+    return r;
+}
+
 /** general output for refs.
  * Need O to implenment the method: void output(std::ostream& s)const.
  * Don't forget virtual when needed.
@@ -1031,6 +1695,31 @@ operator<<(std::wostream& s, const ref_<O,A,T,R>& y)
         return key()==y.key();\
     }\
 
+namespace detail{
+
+/** H::compute(x) for x, cached in x if its refc_t is a hrefc_t.
+ */
+template<typename H, typename O, typename A, typename T, typename R>
+typename std::enable_if<!is_hashed<R>::value, size_t>::type cached_hash(const ref_<O,A,T,R>& x)
+{
+    return H::compute(x);
+}
+
+template<typename H, typename O, typename A, typename T, typename R>
+typename std::enable_if<is_hashed<R>::value, size_t>::type cached_hash(const ref_<O,A,T,R>& x)
+{
+    if(x==none)
+        return H::compute(x);
+    size_t h;
+    if(!x._rp->get_hash(&hash_id<H>::id, h)){
+        h=H::compute(x);
+        x._rp->set_hash(&hash_id<H>::id, h);
+    }
+    return h;
+}
+
+} // ns detail
+
 /** general key_hash for refs.
  * Need T::obj_t to implenment T1 key()const, and T1 must support std::hash.
  * Don't forget virtual when needed.
@@ -1039,6 +1728,11 @@ operator<<(std::wostream& s, const ref_<O,A,T,R>& y)
 template<typename T>struct key_hash{
 public:
     size_t operator()(const T& x)const
+    {
+        return detail::cached_hash<key_hash>(x);
+    }
+
+    static size_t compute(const T& x)
     {
         if(x==none)
             return 0;
@@ -1060,6 +1754,11 @@ public:
 template<typename T, int key_seq=0>struct subkey_hash{
 public:
     size_t operator()(const T& x)const
+    {
+        return detail::cached_hash<subkey_hash>(x);
+    }
+
+    static size_t compute(const T& x)
     {
         typedef decltype(std::get<key_seq>(x->key())) ref_t;
         typedef typename std::remove_reference<ref_t>::type const_key_t;
@@ -1071,6 +1770,21 @@ public:
     }
 };
 
+/** a ref_ type caching the hash of its object, for keys of unordered containers.
+ * @see hrefc_t
+ */
+template<typename T, typename traits=ref_traits<T> >
+using href_=ref_<T, smart_allocator<T>, traits, detail::hrefc_t<> >;
+
+/** a copy-on-write ref_ type, for values mostly read and shared.
+ * Copies of a ref share the object, and the first non-const access through a ref,
+ * e.g. operator->, operator[] or +=, clones the object if it is shared. Objects
+ * with copy_to() are cloned by copy(), others by the copy ctor.
+ * Note: const accesses never clone, so prefer const refs for reading.
+ */
+template<typename T>
+using cowref_=ref_<T, smart_allocator<T>, cow_traits<T> >;
+
 /**
  * @}
  * @}
@@ -1111,6 +1825,11 @@ public:
     typedef size_t     result_type;
     typedef proton::ref_<O,A,T,R>      argument_type;
     inline size_t operator()(const proton::ref_<O,A,T,R> &s) const noexcept
+    {
+        return proton::detail::cached_hash<hash>(s);
+    }
+
+    static size_t compute(const proton::ref_<O,A,T,R> &s)
     {
         if(s==proton::none)
             return 0;
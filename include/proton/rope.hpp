@@ -0,0 +1,1043 @@
+#ifndef PROTON_ROPE_HEADER
+#define PROTON_ROPE_HEADER
+
+/** @file rope.hpp
+ *  @brief a string as a balanced tree of chunks, for editing large texts.
+ */
+
+#include <iostream>
+#include <iterator>
+#include <string>
+#include <cstring>
+#include <algorithm>
+#include <stdexcept>
+#include <proton/base.hpp>
+#include <proton/pool.hpp>
+#include <proton/string_view.hpp>
+#include <proton/small_string.hpp>
+#include <proton/string.hpp>
+
+namespace proton{
+
+namespace detail{
+
+/** a node of a rope, followed by the chars of a leaf.
+ * Nodes are shared by ropes and never changed while shared.
+ */
+struct rope_node{
+    size_t refc;
+    size_t size;        ///< the chars in the subtree
+    size_t cap;         ///< the capacity of a leaf
+    unsigned height;    ///< 0 for leaves
+    rope_node* left;
+    rope_node* right;
+};
+
+} // ns detail
+
+/** @addtogroup str
+ * @{
+ */
+
+/** a string kept in chunks of up to about 1KB, the leaves of an AVL tree.
+ * Inserting, deleting, slicing and concatenating cost O(log n) and copy at most
+ * the two chunks at the ends of the cut, and copies of a rope share its chunks,
+ * so long texts can be built up and spliced without moving the whole of them.
+ * Appending to a rope not shared with others fills its last chunk in place.
+ * Chunks are allocated by allocator, from pools by default.
+ *
+ * The python-like interfaces of basic_string_ are provided where they fit,
+ * and str() flattens a rope into a basic_string_.
+ * Copies share chunks with counts not protected by locks, so don't use
+ * copies of a rope in different threads.
+ * @param CharT the char type
+ * @param allocator the allocator of chunks, with the static interface of smart_allocator
+ */
+template<typename CharT, typename Traits=std::char_traits<CharT>,
+         typename allocator=smart_allocator<CharT> >
+class basic_rope_ {
+public:
+    typedef CharT value_type;
+    typedef Traits traits_type;
+    typedef allocator allocator_type;
+    typedef size_t size_type;
+    typedef long offset_t;
+    typedef basic_string_view_<CharT,Traits> view_t;
+    typedef basic_string_<CharT,Traits,allocator> string_t;
+    static constexpr size_t npos=size_t(-1);
+
+    /** the chars of a new chunk at most.
+     */
+    static constexpr size_t leaf_max=1024/sizeof(CharT);
+
+protected:
+    typedef detail::rope_node node;
+    typedef typename allocator::template rebind<char>::other byte_alloc;
+
+    node* _root;
+
+    /////////////////////////////////////////////
+    // nodes; functions taking nodes consume a ref of each, and return new refs
+
+    static CharT* chars(node* t)
+    {
+        return (CharT*)(t+1);
+    }
+
+    static unsigned height(node* t)
+    {
+        return t ? t->height : 0;
+    }
+
+    static size_t size(node* t)
+    {
+        return t ? t->size : 0;
+    }
+
+    static node* retain(node* t)
+    {
+        if(t)
+            t->refc++;
+        return t;
+    }
+
+    static void release(node* t)
+    {
+        if(t && --t->refc==0){
+            if(t->height){
+                release(t->left);
+                release(t->right);
+            }
+            byte_alloc::confiscate(t);
+        }
+    }
+
+    // a leaf of n chars from s, with room for cap chars
+    static node* new_leaf(const CharT* s, size_t n, size_t cap)
+    {
+        size_t bytes=sizeof(node)+cap*sizeof(CharT);
+        node* t=(node*)byte_alloc::allocate(bytes);
+        t->refc=1;
+        t->size=n;
+        t->cap=(detail::alloc_capacity<byte_alloc>::get(t, bytes)-sizeof(node))/sizeof(CharT);
+        t->height=0;
+        t->left=t->right=NULL;
+        if(n)
+            Traits::copy(chars(t), s, n);
+        return t;
+    }
+
+    // the node of l and r, their heights differing by 1 at most
+    static node* new_node(node* l, node* r)
+    {
+        node* t=(node*)byte_alloc::allocate(sizeof(node));
+        t->refc=1;
+        t->size=l->size+r->size;
+        t->cap=0;
+        t->height=std::max(l->height, r->height)+1;
+        t->left=l;
+        t->right=r;
+        return t;
+    }
+
+    // take the children of t, reusing the refs of t if it's not shared
+    static void unpack(node* t, node*& l, node*& r)
+    {
+        l=t->left;
+        r=t->right;
+        if(t->refc==1)
+            byte_alloc::confiscate(t);
+        else{
+            retain(l);
+            retain(r);
+            t->refc--;
+        }
+    }
+
+    // a balanced tree of the chars of s
+    static node* build(const CharT* s, size_t n)
+    {
+        if(n<=leaf_max)
+            return n ? new_leaf(s, n, n) : NULL;
+        size_t k=(n-1)/leaf_max+1;
+        size_t m=k/2*leaf_max;
+        return new_node(build(s, m), build(s+m, n-m));
+    }
+
+    // copy the chars of t to p
+    static CharT* flatten(node* t, CharT* p)
+    {
+        if(!t)
+            return p;
+        if(!t->height){
+            Traits::copy(p, chars(t), t->size);
+            return p+t->size;
+        }
+        return flatten(t->right, flatten(t->left, p));
+    }
+
+    // l and r, rotated if their heights differ by 2, or joined if by more
+    static node* balance(node* l, node* r)
+    {
+        unsigned hl=height(l), hr=height(r);
+        if(hr>hl+2 || hl>hr+2)
+            return join(l, r);
+        if(hr==hl+2){
+            node *rl, *rr;
+            unpack(r, rl, rr);
+            if(height(rl)<=height(rr))
+                return new_node(new_node(l, rl), rr);
+            node *a, *b;
+            unpack(rl, a, b);
+            return new_node(new_node(l, a), new_node(b, rr));
+        }
+        if(hl==hr+2){
+            node *ll, *lr;
+            unpack(l, ll, lr);
+            if(height(lr)<=height(ll))
+                return new_node(ll, new_node(lr, r));
+            node *a, *b;
+            unpack(lr, a, b);
+            return new_node(new_node(ll, a), new_node(b, r));
+        }
+        return new_node(l, r);
+    }
+
+    // b after a, joined along the spine of the higher one
+    static node* join(node* a, node* b)
+    {
+        if(!a)
+            return b;
+        if(!b)
+            return a;
+        size_t n=a->size+b->size;
+        if(n<=leaf_max){
+            // small ones merge into a leaf, in place if a is an unshared leaf
+            if(!a->height && a->refc==1 && n<=a->cap){
+                flatten(b, chars(a)+a->size);
+                a->size=n;
+                release(b);
+                return a;
+            }
+            node* t=new_leaf(NULL, 0, n);
+            flatten(b, flatten(a, chars(t)));
+            t->size=n;
+            release(a);
+            release(b);
+            return t;
+        }
+        if(a->height>b->height+1){
+            node *l, *r;
+            unpack(a, l, r);
+            return balance(l, join(r, b));
+        }
+        if(b->height>a->height+1){
+            node *l, *r;
+            unpack(b, l, r);
+            return balance(join(a, l), r);
+        }
+        return new_node(a, b);
+    }
+
+    // cut t into the first i chars and the rest
+    static void split(node* t, size_t i, node*& l, node*& r)
+    {
+        if(!t || i==0){
+            l=NULL;
+            r=t;
+            return;
+        }
+        if(i>=t->size){
+            l=t;
+            r=NULL;
+            return;
+        }
+        if(!t->height){
+            r=new_leaf(chars(t)+i, t->size-i, t->size-i);
+            if(t->refc==1){
+                t->size=i;
+                l=t;
+            }
+            else{
+                l=new_leaf(chars(t), i, i);
+                release(t);
+            }
+            return;
+        }
+        node *a, *b;
+        unpack(t, a, b);
+        if(i<=a->size){
+            node* x;
+            split(a, i, l, x);
+            r=join(x, b);
+        }
+        else{
+            node* x;
+            split(b, i-a->size, x, r);
+            l=join(a, x);
+        }
+    }
+
+    // call f(p, n) on the chunks of [b,e) of t in order, till it returns false
+    template<typename F>
+    static bool each(node* t, size_t b, size_t e, F& f)
+    {
+        if(!t || b>=e)
+            return true;
+        if(!t->height)
+            return f((const CharT*)chars(t)+b, e-b);
+        size_t m=t->left->size;
+        if(b<m && !each(t->left, b, std::min(e, m), f))
+            return false;
+        if(e>m)
+            return each(t->right, b>m ? b-m : 0, e-m, f);
+        return true;
+    }
+
+    // call f(p, n) on the chunks of [b,e) of t in reverse order, till it returns false
+    template<typename F>
+    static bool each_reverse(node* t, size_t b, size_t e, F& f)
+    {
+        if(!t || b>=e)
+            return true;
+        if(!t->height)
+            return f((const CharT*)chars(t)+b, e-b);
+        size_t m=t->left->size;
+        if(e>m && !each_reverse(t->right, b>m ? b-m : 0, e-m, f))
+            return false;
+        if(b<m)
+            return each_reverse(t->left, b, std::min(e, m), f);
+        return true;
+    }
+
+    // the leaf of the i-th char, and the offset of its first char
+    static node* leaf_at(node* t, size_t i, size_t& base)
+    {
+        base=0;
+        while(t->height){
+            if(i<t->left->size)
+                t=t->left;
+            else{
+                i-=t->left->size;
+                base+=t->left->size;
+                t=t->right;
+            }
+        }
+        return t;
+    }
+
+    explicit basic_rope_(node* t):_root(t)
+    {}
+
+    offset_t offset(offset_t i)const
+    {
+        if(i<0)
+            i+=size();
+        PROTON_THROW_IF(i<0 || (size_t)i>=size(), "out of range, offset is " << i
+                         << " while size is " << size() );
+        return i;
+    }
+
+    // clamp an offset to [0, size()] like python
+    size_t fix_offset(offset_t i)const
+    {
+        offset_t n=(offset_t)size();
+        if(i<0)
+            i+=n;
+        return i<0 ? 0 : (i>n ? n : i);
+    }
+
+    void fix_range(offset_t& i, offset_t& j)const
+    {
+        detail::fix_slice((offset_t)size(), i, j);
+    }
+
+    // [i,j) of the chars, i<=j<=size()
+    basic_rope_ slice(size_t i, size_t j)const
+    {
+        node *l, *r, *a, *b;
+        split(retain(_root), j, l, r);
+        release(r);
+        split(l, i, a, b);
+        release(a);
+        return basic_rope_(b);
+    }
+
+public:
+    /** the iterator over chars, random access and read-only.
+     * It keeps the chunk of the last char read, so a scan looks up each chunk once.
+     */
+    class const_iterator{
+    protected:
+        const basic_rope_* _r;
+        size_t _i;
+        mutable const CharT* _p;
+        mutable size_t _b, _e; // the offsets of the chars of _p
+
+    public:
+        typedef std::random_access_iterator_tag iterator_category;
+        typedef CharT value_type;
+        typedef offset_t difference_type;
+        typedef const CharT* pointer;
+        typedef const CharT& reference;
+
+        const_iterator():_r(NULL), _i(0), _p(NULL), _b(0), _e(0)
+        {}
+
+        const_iterator(const basic_rope_* r, size_t i):_r(r), _i(i), _p(NULL), _b(0), _e(0)
+        {}
+
+        const CharT& operator*()const
+        {
+            if(_i<_b || _i>=_e){
+                node* t=leaf_at(_r->_root, _i, _b);
+                _p=chars(t);
+                _e=_b+t->size;
+            }
+            return _p[_i-_b];
+        }
+
+        const CharT* operator->()const
+        {
+            return &**this;
+        }
+
+        const CharT& operator[](offset_t n)const
+        {
+            return *(*this+n);
+        }
+
+        const_iterator& operator++()
+        {
+            ++_i;
+            return *this;
+        }
+
+        const_iterator operator++(int)
+        {
+            const_iterator r=*this;
+            ++_i;
+            return r;
+        }
+
+        const_iterator& operator--()
+        {
+            --_i;
+            return *this;
+        }
+
+        const_iterator operator--(int)
+        {
+            const_iterator r=*this;
+            --_i;
+            return r;
+        }
+
+        const_iterator& operator+=(offset_t n)
+        {
+            _i+=n;
+            return *this;
+        }
+
+        const_iterator& operator-=(offset_t n)
+        {
+            _i-=n;
+            return *this;
+        }
+
+        const_iterator operator+(offset_t n)const
+        {
+            const_iterator r=*this;
+            r._i+=n;
+            return r;
+        }
+
+        friend const_iterator operator+(offset_t n, const const_iterator& x)
+        {
+            return x+n;
+        }
+
+        const_iterator operator-(offset_t n)const
+        {
+            const_iterator r=*this;
+            r._i-=n;
+            return r;
+        }
+
+        offset_t operator-(const const_iterator& x)const
+        {
+            return (offset_t)_i-(offset_t)x._i;
+        }
+
+        bool operator==(const const_iterator& x)const
+        {
+            return _i==x._i;
+        }
+
+        bool operator!=(const const_iterator& x)const
+        {
+            return _i!=x._i;
+        }
+
+        bool operator<(const const_iterator& x)const
+        {
+            return _i<x._i;
+        }
+
+        bool operator>(const const_iterator& x)const
+        {
+            return _i>x._i;
+        }
+
+        bool operator<=(const const_iterator& x)const
+        {
+            return _i<=x._i;
+        }
+
+        bool operator>=(const const_iterator& x)const
+        {
+            return _i>=x._i;
+        }
+    };
+
+    typedef const_iterator iterator;
+
+public:
+    basic_rope_():_root(NULL)
+    {}
+
+    /** copy chars; conversions are explicit, so that operators taking views or
+     * ropes aren't ambiguous for strings.
+     */
+    explicit basic_rope_(const CharT* s):_root(build(s, Traits::length(s)))
+    {}
+
+    basic_rope_(const CharT* s, size_t n):_root(build(s, n))
+    {}
+
+    basic_rope_(size_t n, CharT c):_root(NULL)
+    {
+        CharT buf[leaf_max];
+        Traits::assign(buf, std::min(n, leaf_max), c);
+        for(; n>leaf_max; n-=leaf_max)
+            append(buf, leaf_max);
+        append(buf, n);
+    }
+
+    /** copy chars from a view, or anything converting to it.
+     */
+    explicit basic_rope_(const view_t& s):_root(build(s.data(), s.size()))
+    {}
+
+    template<typename A>
+    explicit basic_rope_(const std::basic_string<CharT,Traits,A>& s):_root(build(s.data(), s.size()))
+    {}
+
+    /** a copy sharing all chunks, O(1).
+     */
+    basic_rope_(const basic_rope_& x):_root(retain(x._root))
+    {}
+
+    basic_rope_(basic_rope_&& x)noexcept:_root(x._root)
+    {
+        x._root=NULL;
+    }
+
+    ~basic_rope_()
+    {
+        release(_root);
+    }
+
+    basic_rope_& operator=(const basic_rope_& x)
+    {
+        node* t=retain(x._root);
+        release(_root);
+        _root=t;
+        return *this;
+    }
+
+    basic_rope_& operator=(basic_rope_&& x)noexcept
+    {
+        if(this!=&x){
+            release(_root);
+            _root=x._root;
+            x._root=NULL;
+        }
+        return *this;
+    }
+
+    basic_rope_& operator=(const view_t& s)
+    {
+        return assign(s.data(), s.size());
+    }
+
+    basic_rope_& assign(const CharT* s, size_t n)
+    {
+        node* t=build(s, n); // s may be in this rope
+        release(_root);
+        _root=t;
+        return *this;
+    }
+
+    size_t size()const
+    {
+        return size(_root);
+    }
+
+    size_t length()const
+    {
+        return size(_root);
+    }
+
+    bool empty()const
+    {
+        return _root==NULL;
+    }
+
+    /** the height of the tree, O(log(size())).
+     */
+    unsigned height()const
+    {
+        return height(_root);
+    }
+
+    const_iterator begin()const
+    {
+        return const_iterator(this, 0);
+    }
+
+    const_iterator end()const
+    {
+        return const_iterator(this, size());
+    }
+
+    /** [i] in python, O(log n).
+     */
+    CharT operator[](offset_t i)const
+    {
+        size_t base;
+        size_t k=offset(i);
+        return chars(leaf_at(_root, k, base))[k-base];
+    }
+
+    /** a copy of the chars in a basic_string_.
+     */
+    string_t str()const
+    {
+        string_t r;
+        r.resize(size());
+        if(_root)
+            flatten(_root, &*r.begin());
+        return r;
+    }
+
+    /** a copy in a std::basic_string, including basic_string_.
+     */
+    template<typename A>
+    operator std::basic_string<CharT,Traits,A>()const
+    {
+        std::basic_string<CharT,Traits,A> r;
+        r.resize(size());
+        if(_root)
+            flatten(_root, &*r.begin());
+        return r;
+    }
+
+    /** call f(view_t) on the chunks in order, a way to read chars without copying.
+     */
+    template<typename F>
+    void each_chunk(F&& f)const
+    {
+        auto g=[&f](const CharT* p, size_t n){
+            f(view_t(p, n));
+            return true;
+        };
+        each(_root, 0, size(), g);
+    }
+
+    void clear()
+    {
+        release(_root);
+        _root=NULL;
+    }
+
+    void swap(basic_rope_& x)
+    {
+        std::swap(_root, x._root);
+    }
+
+    /** does nothing, for the format engine.
+     */
+    void reserve(size_t n)
+    {}
+
+    basic_rope_& append(const CharT* s, size_t n)
+    {
+        if(!n)
+            return *this;
+        // fill the last leaf in place if no node down to it is shared
+        node** slot=&_root;
+        node* path[64];
+        unsigned d=0;
+        while(*slot && (*slot)->refc==1 && (*slot)->height){
+            path[d++]=*slot;
+            slot=&(*slot)->right;
+        }
+        node* t=*slot;
+        if(t && t->refc==1 && !t->height && t->size<leaf_max){
+            if(t->size+n>t->cap){
+                // grow by doubling up to leaf_max
+                size_t cap=std::min(std::max(t->size+n, t->size*2), leaf_max);
+                node* x=new_leaf(chars(t), t->size, cap);
+                if(s>=chars(t) && s<chars(t)+t->size) // s may be in the leaf
+                    s=chars(x)+(s-chars(t));
+                byte_alloc::confiscate(t);
+                *slot=t=x;
+            }
+            size_t k=std::min(n, t->cap-t->size);
+            Traits::copy(chars(t)+t->size, s, k);
+            t->size+=k;
+            for(unsigned i=0; i<d; i++)
+                path[i]->size+=k;
+            s+=k;
+            n-=k;
+        }
+        if(n)
+            _root=join(_root, build(s, n));
+        return *this;
+    }
+
+    basic_rope_& append(const view_t& s)
+    {
+        return append(s.data(), s.size());
+    }
+
+    /** concatenate x, sharing its chunks, O(log n).
+     */
+    basic_rope_& append(const basic_rope_& x)
+    {
+        _root=join(_root, retain(x._root));
+        return *this;
+    }
+
+    void push_back(CharT c)
+    {
+        append(&c, 1);
+    }
+
+    basic_rope_& operator+=(const view_t& s)
+    {
+        return append(s.data(), s.size());
+    }
+
+    basic_rope_& operator+=(const basic_rope_& x)
+    {
+        return append(x);
+    }
+
+    basic_rope_& operator+=(CharT c)
+    {
+        push_back(c);
+        return *this;
+    }
+
+    basic_rope_ operator+(const view_t& s)const
+    {
+        basic_rope_ r(*this);
+        r.append(s);
+        return r;
+    }
+
+    basic_rope_ operator+(const basic_rope_& x)const
+    {
+        return basic_rope_(join(retain(_root), retain(x._root)));
+    }
+
+    /** repeat n times, sharing chunks, O(log n) joins.
+     */
+    basic_rope_ operator*(size_t n)const
+    {
+        basic_rope_ r, x(*this);
+        while(n){
+            if(n&1)
+                r.append(x);
+            n>>=1;
+            if(n)
+                x.append(x);
+        }
+        return r;
+    }
+
+    /** insert s before the i-th char, i is clamped to [-size(), size()] like python.
+     */
+    basic_rope_& insert(offset_t i, const view_t& s)
+    {
+        return insert(i, basic_rope_(s));
+    }
+
+    basic_rope_& insert(offset_t i, const basic_rope_& x)
+    {
+        node *l, *r;
+        node* t=retain(x._root); // x may be this rope
+        split(_root, fix_offset(i), l, r);
+        _root=join(join(l, t), r);
+        return *this;
+    }
+
+    /** delete the i-th char
+     */
+    void del(offset_t i)
+    {
+        i=offset(i);
+        del(i, i+1);
+    }
+
+    /** delete from i-th to the j-th chars
+     */
+    void del(offset_t i, offset_t j)
+    {
+        fix_range(i,j);
+        if(i==j)
+            return;
+        node *l, *r, *a, *b;
+        split(_root, j, l, r);
+        split(l, i, a, b);
+        release(b);
+        _root=join(a, r);
+    }
+
+    /** slice of [i:], O(log n)
+     */
+    basic_rope_ operator()(offset_t i)const
+    {
+        return slice(fix_offset(i), size());
+    }
+
+    /** slice of [i:j], O(log n)
+     */
+    basic_rope_ operator()(offset_t i, offset_t j)const
+    {
+        fix_range(i,j);
+        return slice(i, j);
+    }
+
+    /** slice of [i:j:k]
+     */
+    basic_rope_ operator()(offset_t i, offset_t j, size_t k)const
+    {
+        fix_range(i,j);
+        string_t r;
+        r.reserve((j-i)/k+1);
+        auto it=begin()+i;
+        for(offset_t n=i; n<j; n+=k,it+=k)
+            r.push_back(*it);
+        return basic_rope_(r);
+    }
+
+    /** the offset of the first c from pos, or npos.
+     */
+    size_t find(CharT c, size_t pos=0)const
+    {
+        size_t r=npos, base=pos;
+        auto f=[&](const CharT* p, size_t n){
+            const CharT* q=detail::str_scan<CharT>::find(p, p+n, c);
+            if(q!=p+n){
+                r=base+(q-p);
+                return false;
+            }
+            base+=n;
+            return true;
+        };
+        each(_root, pos, size(), f);
+        return r;
+    }
+
+    /** the offset of the first s from pos, or npos.
+     */
+    size_t find(const view_t& s, size_t pos=0)const
+    {
+        if(pos>size())
+            return npos;
+        if(s.size()==1)
+            return find(s[0], pos);
+        auto it=std::search(begin()+pos, end(), s.begin(), s.end());
+        return it==end() && !s.empty() ? npos : (size_t)(it-begin());
+    }
+
+    /** total number of occurences of a char.
+     */
+    size_t count(CharT c)const
+    {
+        size_t r=0;
+        auto f=[&](const CharT* p, size_t n){
+            r+=detail::str_scan<CharT>::count(p, p+n, c);
+            return true;
+        };
+        each(_root, 0, size(), f);
+        return r;
+    }
+
+    bool startswith(const view_t& s)const
+    {
+        if(s.size()>size())
+            return false;
+        const CharT* q=s.data();
+        auto f=[&](const CharT* p, size_t n){
+            if(Traits::compare(p, q, n))
+                return false;
+            q+=n;
+            return true;
+        };
+        return each(_root, 0, s.size(), f);
+    }
+
+    bool endswith(const view_t& s)const
+    {
+        if(s.size()>size())
+            return false;
+        const CharT* q=s.data()+s.size();
+        auto f=[&](const CharT* p, size_t n){
+            q-=n;
+            return !Traits::compare(p, q, n);
+        };
+        return each_reverse(_root, size()-s.size(), size(), f);
+    }
+
+    /** a copy without leading and trailing chars of spc, sharing the chunks between.
+     */
+    basic_rope_ strip(const view_t& spc=detail::vals<CharT>::ws)const
+    {
+        typedef detail::str_scan<CharT> scan;
+        typename scan::set_t set(spc.data(), spc.size());
+        size_t i=0, j=size();
+        auto f=[&](const CharT* p, size_t n){
+            const CharT* q=scan::first_not_of(p, p+n, set);
+            i+=q-p;
+            return q==p+n;
+        };
+        each(_root, 0, j, f);
+        if(i==j)
+            return basic_rope_();
+        auto g=[&](const CharT* p, size_t n){
+            const CharT* q=scan::last_not_of(p, p+n, set);
+            if(q){
+                j-=p+n-q-1;
+                return false;
+            }
+            j-=n;
+            return true;
+        };
+        each_reverse(_root, i, j, g);
+        return slice(i, j);
+    }
+
+    /** split as basic_string_::split() does, into strings.
+     */
+    deque_<string_t> split(const view_t& delim=view_t(), int null_unite=-1)const
+    {
+        return str().split(delim, null_unite);
+    }
+
+    /** append f % a, see basic_string_::operator%().
+     */
+    template<typename V>
+    basic_rope_& format(const CharT* f, const V& a)
+    {
+        detail::format_writer<CharT, basic_rope_> w(*this, f, 0);
+        detail::format_args<CharT,V>::write(w, a);
+        w.finish();
+        return *this;
+    }
+
+    /** rope % V, formatted into a rope.
+     */
+    template<typename V>
+    basic_rope_ operator%(const V& a)const
+    {
+        basic_rope_ r;
+        r.format(str().c_str(), a);
+        return r;
+    }
+
+    int compare(const basic_rope_& x)const
+    {
+        if(_root==x._root)
+            return 0;
+        auto r=std::mismatch(begin(), begin()+std::min(size(), x.size()), x.begin());
+        if(r.first-begin()<(offset_t)std::min(size(), x.size()))
+            return Traits::lt(*r.first, *r.second) ? -1 : 1;
+        return size()<x.size() ? -1 : (size()>x.size() ? 1 : 0);
+    }
+
+    bool operator==(const basic_rope_& x)const
+    {
+        return size()==x.size() && compare(x)==0;
+    }
+
+    bool operator!=(const basic_rope_& x)const
+    {
+        return !(*this==x);
+    }
+
+    bool operator<(const basic_rope_& x)const
+    {
+        return compare(x)<0;
+    }
+
+    bool operator==(const view_t& s)const
+    {
+        return size()==s.size() && startswith(s);
+    }
+
+    bool operator!=(const view_t& s)const
+    {
+        return !(*this==s);
+    }
+
+    friend bool operator==(const view_t& s, const basic_rope_& x)
+    {
+        return x==s;
+    }
+
+    friend bool operator!=(const view_t& s, const basic_rope_& x)
+    {
+        return !(x==s);
+    }
+};
+
+template<typename C, typename T, typename A>
+constexpr size_t basic_rope_<C,T,A>::npos;
+
+template<typename C, typename T, typename A>
+constexpr size_t basic_rope_<C,T,A>::leaf_max;
+
+/** a rope of char.
+ */
+typedef basic_rope_<char> rope;
+
+/** a rope of wchar_t.
+ */
+typedef basic_rope_<wchar_t> wrope;
+
+template<typename C, typename T, typename A>
+basic_rope_<C,T,A> operator*(size_t n, const basic_rope_<C,T,A>& s)
+{
+    return s*n;
+}
+
+template<typename C, typename T, typename A>
+std::basic_ostream<C,T>& operator<<(std::basic_ostream<C,T>& o, const basic_rope_<C,T,A>& x)
+{
+    x.each_chunk([&o](const basic_string_view_<C,T>& s){
+        o.write(s.data(), s.size());
+    });
+    return o;
+}
+
+/**
+ * @}
+ */
+
+} // ns proton
+
+#endif // PROTON_ROPE_HEADER
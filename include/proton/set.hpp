@@ -8,6 +8,7 @@
 #include <proton/base.hpp>
 #include <proton/pool.hpp>
 #include <proton/ref.hpp>
+#include <proton/hash.hpp>
 
 namespace proton{
 
@@ -108,13 +109,13 @@ public:
 
     /** move ctor.
      */
-    set_(set_&& x)noexcept:baseT(x)
+    set_(set_&& x)noexcept:baseT(std::move(x))
     {}
 
     explicit set_(const baseT& x):baseT(x)
     {}
 
-    set_(baseT&& x)noexcept:baseT(x)
+    set_(baseT&& x)noexcept:baseT(std::move(x))
     {}
 
     /** assign.
@@ -127,7 +128,7 @@ public:
 
     set_& operator=(set_&& x)noexcept
     {
-        baseT::operator=(x);
+        baseT::operator=(std::move(x));
         return *this;
     }
 
@@ -139,7 +140,7 @@ public:
 
     set_& operator=(baseT&& x)noexcept
     {
-        baseT::operator=(x);
+        baseT::operator=(std::move(x));
         return *this;
     }
 
@@ -353,4 +354,20 @@ struct has_t<set_<T,C,allocT> >{
 } // ns detail
 
 } // ns proton
+
+namespace std{
+
+template<typename T, typename C, typename A>
+struct hash<proton::set_<T,C,A> >{
+public:
+    typedef size_t     result_type;
+    typedef proton::set_<T,C,A>      argument_type;
+    size_t operator()(const proton::set_<T,C,A>& x) const
+    {
+        return proton::hash_range(x.begin(), x.end(), proton::hash_combine(proton::detail::hash_seed, x.size()));
+    }
+};
+
+} // ns std
+
 #endif // PROTON_SET_HEADER
@@ -0,0 +1,434 @@
+#ifndef PROTON_SLICE_HEADER
+#define PROTON_SLICE_HEADER
+
+/** @file slice.hpp
+ *  @brief views of python-like slices [i:j:k] of sequences, without copying items.
+ */
+
+#include <iostream>
+#include <iterator>
+#include <algorithm>
+#include <string>
+#include <type_traits>
+#include <proton/base.hpp>
+
+namespace proton{
+
+template<typename It>
+class slice_;
+
+namespace detail{
+
+// clamp [i:j] to the items of a sequence of size n, as fix_range() of vector_ does
+template<typename offset_t>
+void fix_slice(offset_t n, offset_t& i, offset_t& j)
+{
+    if(i<0)
+        i+=n;
+    if(j<0)
+        j+=n;
+    if(i>=n || j<=0 || j<=i){
+        i=0;
+        j=0;
+        return;
+    }
+    if(i<0)
+        i=0;
+    if(j>n)
+        j=n;
+}
+
+template<typename X>
+struct is_slice:std::false_type{};
+
+template<typename It>
+struct is_slice<slice_<It> >:std::true_type{};
+
+template<typename C>
+struct is_slice_char:std::integral_constant<bool,
+    std::is_same<C, char>::value || std::is_same<C, wchar_t>::value
+    || std::is_same<C, char16_t>::value || std::is_same<C, char32_t>::value>
+{};
+
+// the items a slice is compared with: a sequence, or the chars of a C string,
+// without the terminating NUL of a char array
+template<typename X, typename V=void>
+struct seq_items{
+    template<typename Y=X>
+    static auto begin(const Y& y) -> decltype(std::begin(y))
+    {
+        return std::begin(y);
+    }
+
+    template<typename Y=X>
+    static auto end(const Y& y) -> decltype(std::end(y))
+    {
+        return std::end(y);
+    }
+};
+
+template<typename C, size_t N>
+struct seq_items<C[N], typename std::enable_if<is_slice_char<C>::value>::type>{
+    static const C* begin(const C (&y)[N])
+    {
+        return y;
+    }
+
+    static const C* end(const C (&y)[N])
+    {
+        return y+N-(N>0 && y[N-1]==C());
+    }
+};
+
+template<typename C>
+struct seq_items<C*, typename std::enable_if<is_slice_char<typename std::remove_const<C>::type>::value>::type>{
+    static C* begin(C* y)
+    {
+        return y;
+    }
+
+    static C* end(C* y)
+    {
+        return y+std::char_traits<typename std::remove_const<C>::type>::length(y);
+    }
+};
+
+} // ns detail
+
+/** @addtogroup seq
+ * @{
+ */
+
+/** a view of every k-th item of a sequence, the result of view(i,j,k) of vector_,
+ * deque_ and basic_string_.
+ * It keeps an iterator to the first item, the number of items and the step,
+ * so taking a slice allocates nothing and its items are the ones of the sequence.
+ * The sequence must outlive the view, and must not reallocate meanwhile.
+ * @param It a random access iterator of the sequence, a const_iterator for read-only views
+ */
+template<typename It>
+class slice_{
+public:
+    typedef typename std::iterator_traits<It>::value_type value_type;
+    typedef typename std::iterator_traits<It>::reference reference;
+    typedef typename std::iterator_traits<It>::difference_type offset_t;
+    typedef size_t size_type;
+
+    /** the iterator over the items, random access.
+     * It holds an index instead of advancing It by k, which could step past the end.
+     */
+    class iterator{
+    protected:
+        It _b;
+        offset_t _i;
+        offset_t _k;
+
+    public:
+        typedef std::random_access_iterator_tag iterator_category;
+        typedef typename std::iterator_traits<It>::value_type value_type;
+        typedef typename std::iterator_traits<It>::difference_type difference_type;
+        typedef typename std::iterator_traits<It>::pointer pointer;
+        typedef typename std::iterator_traits<It>::reference reference;
+
+        iterator():_b(), _i(0), _k(1)
+        {}
+
+        iterator(It b, offset_t i, offset_t k):_b(b), _i(i), _k(k)
+        {}
+
+        reference operator*()const
+        {
+            return _b[_i*_k];
+        }
+
+        pointer operator->()const
+        {
+            return &_b[_i*_k];
+        }
+
+        reference operator[](offset_t n)const
+        {
+            return _b[(_i+n)*_k];
+        }
+
+        iterator& operator++()
+        {
+            ++_i;
+            return *this;
+        }
+
+        iterator operator++(int)
+        {
+            iterator r=*this;
+            ++_i;
+            return r;
+        }
+
+        iterator& operator--()
+        {
+            --_i;
+            return *this;
+        }
+
+        iterator operator--(int)
+        {
+            iterator r=*this;
+            --_i;
+            return r;
+        }
+
+        iterator& operator+=(offset_t n)
+        {
+            _i+=n;
+            return *this;
+        }
+
+        iterator& operator-=(offset_t n)
+        {
+            _i-=n;
+            return *this;
+        }
+
+        iterator operator+(offset_t n)const
+        {
+            return iterator(_b, _i+n, _k);
+        }
+
+        friend iterator operator+(offset_t n, const iterator& x)
+        {
+            return x+n;
+        }
+
+        iterator operator-(offset_t n)const
+        {
+            return iterator(_b, _i-n, _k);
+        }
+
+        offset_t operator-(const iterator& x)const
+        {
+            return _i-x._i;
+        }
+
+        bool operator==(const iterator& x)const
+        {
+            return _i==x._i;
+        }
+
+        bool operator!=(const iterator& x)const
+        {
+            return _i!=x._i;
+        }
+
+        bool operator<(const iterator& x)const
+        {
+            return _i<x._i;
+        }
+
+        bool operator>(const iterator& x)const
+        {
+            return _i>x._i;
+        }
+
+        bool operator<=(const iterator& x)const
+        {
+            return _i<=x._i;
+        }
+
+        bool operator>=(const iterator& x)const
+        {
+            return _i>=x._i;
+        }
+    };
+
+    typedef iterator const_iterator;
+
+protected:
+    It _b;
+    size_t _n;
+    size_t _k;
+
+    offset_t offset(offset_t i)const
+    {
+        if(i<0)
+            i+=_n;
+        PROTON_THROW_IF(i<0 || (size_t)i>=_n, "out of range, offset is " << i
+                         << " while size is " << _n );
+        return i;
+    }
+
+public:
+    /** an empty slice.
+     */
+    slice_():_b(), _n(0), _k(1)
+    {}
+
+    /** n items from b, every k-th one.
+     */
+    slice_(It b, size_t n, size_t k=1):_b(b), _n(n), _k(k)
+    {}
+
+    /** the items of [b,e) with a step of k, like sequence[i:j:k] in python.
+     */
+    static slice_ of(It b, It e, size_t k=1)
+    {
+        PROTON_THROW_IF(k==0, "slice step cannot be zero");
+        return slice_(b, b<e ? (size_t)(e-b+k-1)/k : 0, k);
+    }
+
+    size_t size()const
+    {
+        return _n;
+    }
+
+    bool empty()const
+    {
+        return _n==0;
+    }
+
+    /** the distance between items in the sequence.
+     */
+    size_t step()const
+    {
+        return _k;
+    }
+
+    iterator begin()const
+    {
+        return iterator(_b, 0, (offset_t)_k);
+    }
+
+    iterator end()const
+    {
+        return iterator(_b, (offset_t)_n, (offset_t)_k);
+    }
+
+    /** [i] in python
+     */
+    reference operator[](offset_t i)const
+    {
+        return _b[offset(i)*(offset_t)_k];
+    }
+
+    reference front()const
+    {
+        return (*this)[0];
+    }
+
+    reference back()const
+    {
+        return (*this)[-1];
+    }
+
+    /** slice of [i:], a view as well
+     */
+    slice_ operator()(offset_t i)const
+    {
+        return (*this)(i, (offset_t)_n, 1);
+    }
+
+    /** slice of [i:j:k] of this slice, a view of the same sequence
+     */
+    slice_ operator()(offset_t i, offset_t j, size_t k=1)const
+    {
+        detail::fix_slice((offset_t)_n, i, j);
+        PROTON_THROW_IF(k==0, "slice step cannot be zero");
+        return slice_(_b+i*(offset_t)_k, (size_t)(j-i+k-1)/k, _k*k);
+    }
+
+    /** copy the items into a new sequence, like vector_<T> or basic_string_.
+     */
+    template<typename C>
+    C to()const
+    {
+        return C(begin(), end());
+    }
+
+    /** equal to a slice with the same items, of any sequence.
+     */
+    template<typename It2>
+    friend bool operator==(const slice_& x, const slice_<It2>& y)
+    {
+        return x.size()==y.size() && std::equal(x.begin(), x.end(), y.begin());
+    }
+
+    template<typename It2>
+    friend bool operator!=(const slice_& x, const slice_<It2>& y)
+    {
+        return !(x==y);
+    }
+
+    /** equal to any sequence with the same items, or to a C string with the same chars.
+     */
+    template<typename X>
+    friend auto operator==(const slice_& x, const X& y) -> typename std::enable_if<
+        !detail::is_slice<X>::value, decltype(detail::seq_items<X>::end(y), true)>::type
+    {
+        return x.size()==(size_t)std::distance(detail::seq_items<X>::begin(y), detail::seq_items<X>::end(y))
+               && std::equal(x.begin(), x.end(), detail::seq_items<X>::begin(y));
+    }
+
+    template<typename X>
+    friend auto operator==(const X& x, const slice_& y) -> typename std::enable_if<
+        !detail::is_slice<X>::value, decltype(detail::seq_items<X>::end(x), true)>::type
+    {
+        return y==x;
+    }
+
+    template<typename X>
+    friend auto operator!=(const slice_& x, const X& y) -> typename std::enable_if<
+        !detail::is_slice<X>::value, decltype(detail::seq_items<X>::end(y), true)>::type
+    {
+        return !(x==y);
+    }
+
+    template<typename X>
+    friend auto operator!=(const X& x, const slice_& y) -> typename std::enable_if<
+        !detail::is_slice<X>::value, decltype(detail::seq_items<X>::end(x), true)>::type
+    {
+        return !(y==x);
+    }
+};
+
+/** a view of x[first:last:step], items of x aren't copied.
+ * It works on any random access sequence, including std::vector, std::deque and std::string.
+ */
+template<typename C>
+slice_<typename C::const_iterator> view(const C& x, long first, long last, size_t step=1)
+{
+    detail::fix_slice((long)x.size(), first, last);
+    return slice_<typename C::const_iterator>::of(x.begin()+first, x.begin()+last, step);
+}
+
+/** a view of x[first:]
+ */
+template<typename C>
+slice_<typename C::const_iterator> view(const C& x, long first)
+{
+    return view(x, first, (long)x.size());
+}
+
+/** output as a list, [a, b, c].
+ */
+template<typename It>
+std::ostream& operator<<(std::ostream& s, const slice_<It>& x)
+{
+    s << "[";
+    bool first=true;
+    for(auto&& t: x){
+        if(first)
+            first=false;
+        else
+            s <<", ";
+        s << t;
+    }
+    s << "]";
+    return s;
+}
+
+/**
+ * @}
+ */
+
+} // ns proton
+
+#endif // PROTON_SLICE_HEADER
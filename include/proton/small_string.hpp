@@ -0,0 +1,479 @@
+#ifndef PROTON_SMALL_STRING_HEADER
+#define PROTON_SMALL_STRING_HEADER
+
+/** @file small_string.hpp
+ *  @brief a string keeping short contents inline, and growing in place in pool chunks.
+ */
+
+#include <iostream>
+#include <string>
+#include <cstring>
+#include <algorithm>
+#include <stdexcept>
+#include <functional>
+#include <proton/base.hpp>
+#include <proton/pool.hpp>
+#include <proton/string_view.hpp>
+
+namespace proton{
+
+namespace detail{
+
+// the usable size of a buffer of n items from allocator, the hook to grow in place
+template<typename allocator>
+struct alloc_capacity{
+    static size_t get(void* p, size_t n)
+    {
+        return n;
+    }
+};
+
+template<typename T, typename pool_tag>
+struct alloc_capacity<smart_allocator<T, pool_tag> >{
+    static size_t get(void* p, size_t n)
+    {
+        return pool_capacity(p)/sizeof(T);
+    }
+};
+
+} // ns detail
+
+/** @addtogroup str
+ * @{
+ */
+
+/** a string with a larger inline buffer than std::basic_string.
+ * Contents up to N chars are kept in the object and never touch the allocator,
+ * which makes it fit for tokens and keys. Longer ones go to chunks of allocator,
+ * using the whole size class of a chunk as capacity, so growing within it
+ * needs no reallocation.
+ * It converts to basic_string_view_ and std::basic_string, and compares and
+ * hashes as strings with the same chars do.
+ * @param CharT the char type
+ * @param N the inline capacity, 23 chars by default for char
+ * @param allocator the allocator of long contents, with the static interface of smart_allocator
+ */
+template<typename CharT, size_t N=24/sizeof(CharT)-1, typename Traits=std::char_traits<CharT>,
+         typename allocator=smart_allocator<CharT> >
+class basic_small_string_ {
+public:
+    typedef CharT value_type;
+    typedef Traits traits_type;
+    typedef allocator allocator_type;
+    typedef CharT* iterator;
+    typedef const CharT* const_iterator;
+    typedef size_t size_type;
+    typedef basic_string_view_<CharT,Traits> view_t;
+    static constexpr size_t npos=size_t(-1);
+    static constexpr size_t inline_capacity=N;
+
+protected:
+    CharT* _p;
+    size_t _n;
+    union{
+        size_t _cap;        // the capacity of a heap buffer
+        CharT _buf[N+1];    // the inline buffer
+    };
+
+    bool is_inline()const
+    {
+        return _p==_buf;
+    }
+
+    void init(const CharT* s, size_t n)
+    {
+        _p=_buf;
+        _n=0;
+        if(n>N)
+            grow(n);
+        Traits::copy(_p, s, n);
+        _n=n;
+        _p[n]=CharT();
+    }
+
+    // get a buffer for at least n chars, keeping the contents
+    void grow(size_t n)
+    {
+        size_t cap=capacity();
+        if(n<=cap)
+            return;
+        n=std::max(n, cap*2);
+        CharT* p=allocator::allocate(n+1);
+        size_t k=detail::alloc_capacity<allocator>::get(p, n+1)-1;
+        Traits::copy(p, _p, _n+1);
+        release();
+        _p=p;
+        _cap=k;
+    }
+
+    void release()
+    {
+        if(!is_inline())
+            allocator::confiscate(_p);
+    }
+
+    void steal(basic_small_string_& x)
+    {
+        if(x.is_inline()){
+            _p=_buf;
+            std::memcpy(_buf, x._buf, sizeof(_buf)); // fixed size, faster than by _n
+        }
+        else{
+            _p=x._p;
+            _cap=x._cap;
+            x._p=x._buf;
+        }
+        _n=x._n;
+        x._n=0;
+        x._buf[0]=CharT();
+    }
+
+public:
+    basic_small_string_():_p(_buf), _n(0)
+    {
+        _buf[0]=CharT();
+    }
+
+    basic_small_string_(const CharT* s)
+    {
+        init(s, Traits::length(s));
+    }
+
+    basic_small_string_(const CharT* s, size_t n)
+    {
+        init(s, n);
+    }
+
+    basic_small_string_(const CharT* b, const CharT* e)
+    {
+        init(b, e-b);
+    }
+
+    basic_small_string_(size_t n, CharT c):_p(_buf), _n(0)
+    {
+        grow(n);
+        Traits::assign(_p, n, c);
+        _n=n;
+        _p[n]=CharT();
+    }
+
+    /** copy chars from a view, or anything converting to it.
+     */
+    basic_small_string_(const view_t& s)
+    {
+        init(s.data(), s.size());
+    }
+
+    template<typename A>
+    basic_small_string_(const std::basic_string<CharT,Traits,A>& s)
+    {
+        init(s.data(), s.size());
+    }
+
+    basic_small_string_(const basic_small_string_& x)
+    {
+        init(x._p, x._n);
+    }
+
+    basic_small_string_(basic_small_string_&& x)noexcept
+    {
+        steal(x);
+    }
+
+    ~basic_small_string_()
+    {
+        release();
+    }
+
+    basic_small_string_& operator=(const basic_small_string_& x)
+    {
+        if(this!=&x)
+            assign(x._p, x._n);
+        return *this;
+    }
+
+    basic_small_string_& operator=(basic_small_string_&& x)noexcept
+    {
+        if(this!=&x){
+            release();
+            steal(x);
+        }
+        return *this;
+    }
+
+    basic_small_string_& operator=(const view_t& s)
+    {
+        return assign(s.data(), s.size());
+    }
+
+    basic_small_string_& assign(const CharT* s, size_t n)
+    {
+        if(n>capacity()){
+            // s may be in this string
+            basic_small_string_ t(s, n);
+            *this=std::move(t);
+            return *this;
+        }
+        Traits::move(_p, s, n);
+        _n=n;
+        _p[n]=CharT();
+        return *this;
+    }
+
+    /** a view of the chars.
+     */
+    operator view_t()const
+    {
+        return view_t(_p, _n);
+    }
+
+    /** a copy in a std::basic_string, including basic_string_.
+     */
+    template<typename A>
+    operator std::basic_string<CharT,Traits,A>()const
+    {
+        return std::basic_string<CharT,Traits,A>(_p, _n);
+    }
+
+    const CharT* data()const
+    {
+        return _p;
+    }
+
+    const CharT* c_str()const
+    {
+        return _p;
+    }
+
+    size_t size()const
+    {
+        return _n;
+    }
+
+    size_t length()const
+    {
+        return _n;
+    }
+
+    bool empty()const
+    {
+        return _n==0;
+    }
+
+    /** the chars it holds without reallocation.
+     */
+    size_t capacity()const
+    {
+        return is_inline() ? N : _cap;
+    }
+
+    CharT* begin()
+    {
+        return _p;
+    }
+
+    CharT* end()
+    {
+        return _p+_n;
+    }
+
+    const CharT* begin()const
+    {
+        return _p;
+    }
+
+    const CharT* end()const
+    {
+        return _p+_n;
+    }
+
+    CharT& operator[](size_t i)
+    {
+        return _p[i];
+    }
+
+    const CharT& operator[](size_t i)const
+    {
+        return _p[i];
+    }
+
+    void reserve(size_t n)
+    {
+        grow(n);
+    }
+
+    void clear()
+    {
+        _n=0;
+        _p[0]=CharT();
+    }
+
+    void resize(size_t n, CharT c=CharT())
+    {
+        if(n>_n){
+            grow(n);
+            Traits::assign(_p+_n, n-_n, c);
+        }
+        _n=n;
+        _p[n]=CharT();
+    }
+
+    void push_back(CharT c)
+    {
+        if(_n==capacity())
+            grow(_n+1);
+        _p[_n++]=c;
+        _p[_n]=CharT();
+    }
+
+    basic_small_string_& append(const CharT* s, size_t n)
+    {
+        if(_n+n>capacity()){
+            // s may be in this string
+            if(s>=_p && s<=_p+_n){
+                size_t off=s-_p;
+                grow(_n+n);
+                s=_p+off;
+            }
+            else
+                grow(_n+n);
+        }
+        Traits::copy(_p+_n, s, n);
+        _n+=n;
+        _p[_n]=CharT();
+        return *this;
+    }
+
+    basic_small_string_& append(const view_t& s)
+    {
+        return append(s.data(), s.size());
+    }
+
+    basic_small_string_& operator+=(const view_t& s)
+    {
+        return append(s.data(), s.size());
+    }
+
+    basic_small_string_& operator+=(CharT c)
+    {
+        push_back(c);
+        return *this;
+    }
+
+    basic_small_string_ operator+(const view_t& s)const
+    {
+        basic_small_string_ r;
+        r.reserve(_n+s.size());
+        r.append(_p, _n);
+        r.append(s);
+        return r;
+    }
+
+    /** a copy of [pos, pos+n) clamped to the end.
+     * @throw std::out_of_range if pos>size().
+     */
+    basic_small_string_ substr(size_t pos, size_t n=npos)const
+    {
+        return view_t(*this).substr(pos, n);
+    }
+
+    size_t find(CharT c, size_t pos=0)const
+    {
+        return view_t(*this).find(c, pos);
+    }
+
+    int compare(const view_t& x)const
+    {
+        return view_t(*this).compare(x);
+    }
+
+    void swap(basic_small_string_& x)
+    {
+        basic_small_string_ t(std::move(x));
+        x=std::move(*this);
+        *this=std::move(t);
+    }
+
+    // compared as views, with views, strings and C strings
+    template<typename X>
+    friend bool operator==(const basic_small_string_& x, const X& y)
+    {
+        return view_t(x)==view_t(y);
+    }
+
+    template<typename X>
+    friend typename std::enable_if<!std::is_same<X, basic_small_string_>::value, bool>::type
+        operator==(const X& x, const basic_small_string_& y)
+    {
+        return view_t(x)==view_t(y);
+    }
+
+    template<typename X>
+    friend bool operator!=(const basic_small_string_& x, const X& y)
+    {
+        return view_t(x)!=view_t(y);
+    }
+
+    template<typename X>
+    friend typename std::enable_if<!std::is_same<X, basic_small_string_>::value, bool>::type
+        operator!=(const X& x, const basic_small_string_& y)
+    {
+        return view_t(x)!=view_t(y);
+    }
+
+    template<typename X>
+    friend bool operator<(const basic_small_string_& x, const X& y)
+    {
+        return view_t(x)<view_t(y);
+    }
+
+    template<typename X>
+    friend typename std::enable_if<!std::is_same<X, basic_small_string_>::value, bool>::type
+        operator<(const X& x, const basic_small_string_& y)
+    {
+        return view_t(x)<view_t(y);
+    }
+};
+
+template<typename C, size_t N, typename T, typename A>
+constexpr size_t basic_small_string_<C,N,T,A>::npos;
+
+template<typename C, size_t N, typename T, typename A>
+constexpr size_t basic_small_string_<C,N,T,A>::inline_capacity;
+
+/** a small string of char.
+ */
+typedef basic_small_string_<char> small_str;
+
+/** a small string of wchar_t.
+ */
+typedef basic_small_string_<wchar_t> small_wstr;
+
+template<typename C, size_t N, typename T, typename A>
+std::basic_ostream<C,T>& operator<<(std::basic_ostream<C,T>& o, const basic_small_string_<C,N,T,A>& x)
+{
+    return o << basic_string_view_<C,T>(x);
+}
+
+/**
+ * @}
+ */
+
+} // ns proton
+
+namespace std{
+
+template<typename C, size_t N, typename T, typename A>
+struct hash<proton::basic_small_string_<C,N,T,A> >{
+public:
+    typedef size_t     result_type;
+    typedef proton::basic_small_string_<C,N,T,A>      argument_type;
+    size_t operator()(const proton::basic_small_string_<C,N,T,A>& s) const noexcept
+    {
+        return std::hash<proton::basic_string_view_<C,T> >()(s);
+    }
+};
+
+} // ns std
+
+#endif // PROTON_SMALL_STRING_HEADER
@@ -6,15 +6,23 @@
 #include <sstream>
 #include <string>
 #include <boost/algorithm/string/predicate.hpp>
-#include <boost/algorithm/string/case_conv.hpp>
 #include <stdexcept>
+#include <algorithm>
+#include <cstdlib>
 #include <cstring>
 #include <cwchar>
+#include <cmath>
+#include <locale>
+#include <limits>
 #include <type_traits>
 #include <proton/base.hpp>
 #include <proton/pool.hpp>
 #include <proton/deque.hpp>
+#include <proton/vector.hpp>
+#include <proton/string_view.hpp>
+#include <proton/slice.hpp>
 #include <proton/tuple.hpp>
+#include <proton/detail/scan.hpp>
 
 namespace proton{
 
@@ -69,73 +77,309 @@ namespace detail{
     };
 }
 
-/** @addtogroup str
- * @{
- */
+namespace detail{
 
-template<typename string>string strip(const string& x)
-{
-    string spc = " \t\n\r";
+// char scanning behind split(), strip(), count() and index()
+template<typename C> struct str_scan{
+    // small sets are copied, so that lazy splitters may keep them
+    struct set_t{
+        const C* s;
+        size_t n;
+        C chars[16];
 
-    long i=x.find_first_not_of(spc);
-    long j=x.find_last_not_of(spc);
+        set_t(const C* x, size_t k):s(x), n(k)
+        {
+            if(n<=16)
+                std::char_traits<C>::copy(chars, x, n);
+        }
 
-    if(i<0 || j<0 || j < i )
-        return "";
+        bool has(C c)const
+        {
+            return std::char_traits<C>::find(n<=16 ? chars : s, n, c)!=NULL;
+        }
+    };
 
-    return x.substr(i,j-i+1);
-}
+    static const C* first_of(const C* b, const C* e, const set_t& s)
+    {
+        for(; b<e; ++b)
+            if(s.has(*b))
+                return b;
+        return e;
+    }
 
-/** split a string.
- * @param r          the output string list, supporting clear() and push_back()
- * @param s          the input string
- * @param spc        the delimiters
- * @param null_unite -1: a.c.t. python depent on token, 0: false, 1: true
- */
-template<typename string_list, typename string> void split(string_list& r, const string& s, string spc="", int null_unite=-1)
-{
-    long pos = 0, begin, end;
+    static const C* first_not_of(const C* b, const C* e, const set_t& s)
+    {
+        for(; b<e; ++b)
+            if(!s.has(*b))
+                return b;
+        return e;
+    }
 
-    r.clear();
+    static const C* last_not_of(const C* b, const C* e, const set_t& s)
+    {
+        while(e>b){
+            --e;
+            if(!s.has(*e))
+                return e;
+        }
+        return NULL;
+    }
+
+    static size_t count(const C* b, const C* e, C c)
+    {
+        return std::count(b, e, c);
+    }
+
+    static const C* find(const C* b, const C* e, C c)
+    {
+        return std::find(b, e, c);
+    }
+
+    // case conversion and case-insensitive compare by the global locale, as boost::algorithm does
+    static void convert_case(C* d, const C* b, const C* e, bool upper)
+    {
+        std::locale loc;
+        const std::ctype<C>& ct=std::use_facet<std::ctype<C> >(loc);
+        for(; b<e; ++b, ++d)
+            *d=(upper ? ct.toupper(*b) : ct.tolower(*b));
+    }
+
+    static bool iequal(const C* a, const C* b, size_t n)
+    {
+        std::locale loc;
+        for(size_t i=0; i<n; i++)
+            if(std::toupper(a[i], loc)!=std::toupper(b[i], loc))
+                return false;
+        return true;
+    }
+};
+
+// SIMD kernels for char, see <proton/detail/scan.hpp>
+template<> struct str_scan<char>{
+    typedef char_set set_t;
+
+    static const char* first_of(const char* b, const char* e, const set_t& s)
+    {
+        return scan_first_of(b, e, s);
+    }
+
+    static const char* first_not_of(const char* b, const char* e, const set_t& s)
+    {
+        return scan_first_not_of(b, e, s);
+    }
 
-    if(spc.size()==0){
+    static const char* last_not_of(const char* b, const char* e, const set_t& s)
+    {
+        return scan_last_not_of(b, e, s);
+    }
+
+    static size_t count(const char* b, const char* e, char c)
+    {
+        return scan_count(b, e, c);
+    }
+
+    static const char* find(const char* b, const char* e, char c)
+    {
+        return scan_find(b, e, c);
+    }
+
+    // ASCII by the kernels, other chars by the global locale one by one
+    static void convert_case(char* d, const char* b, const char* e, bool upper)
+    {
+        const char* p=scan_ascii_case(d, b, e, upper);
+        if(p==e)
+            return;
+        std::locale loc;
+        const std::ctype<char>& ct=std::use_facet<std::ctype<char> >(loc);
+        do{
+            d+=p-b;
+            b=p;
+            *d=(upper ? ct.toupper(*b) : ct.tolower(*b));
+            p=scan_ascii_case(++d, ++b, e, upper);
+        }while(p!=e);
+    }
+
+    static bool iequal(const char* a, const char* b, size_t n)
+    {
+        const char* e=a+n;
+        const char* p=scan_ascii_imismatch(a, e, b);
+        if(p==e)
+            return true;
+        std::locale loc;
+        do{
+            b+=p-a;
+            a=p;
+            if(!((*a | *b) & 0x80))
+                return false; // different ASCII letters
+            if(std::toupper(*a, loc)!=std::toupper(*b, loc))
+                return false;
+            p=scan_ascii_imismatch(++a, e, ++b);
+        }while(p!=e);
+        return true;
+    }
+};
+
+/** the fields of [p,e) split by delimiters, passed to f(begin, end) one by one.
+ * An empty spc means white spaces, see split().
+ */
+template<typename C>
+void split_args(const C*& spc, size_t& n, int& null_unite)
+{
+    if(n==0){
         if(null_unite<0)
             null_unite=1;
-        spc=" \t\n\r";
+        spc=vals<C>::ws;
+        n=std::char_traits<C>::length(spc);
     }
     else{
         if(null_unite<0)
             null_unite=0;
     }
+}
 
-	if(null_unite){
-		do{
-			begin = s.find_first_not_of(spc,pos);
-			if(begin<0)
-				break;
-			end = s.find_first_of(spc,begin);
-			if(end<0)
-				end=s.length();
-			r.push_back(s.substr(begin, end-begin).c_str());
-			pos = end;
-		}
-		while(pos < (long)s.length());
-	}
-	else{
-		while(1){
-			begin = s.find_first_of(spc,pos);
-			if(begin<0){
-				r.push_back(s.substr(pos).c_str());
-				break;
-			}
-			r.push_back(s.substr(pos, begin-pos).c_str());
-			pos = begin + 1;
-            if(pos>=(long)s.length()){
-                r.push_back("");
+template<typename C, typename F>
+void split_fields(const C* p, const C* e, const C* spc, size_t n, int null_unite, F&& f)
+{
+    typedef str_scan<C> scan;
+    split_args(spc, n, null_unite);
+
+    typename scan::set_t set(spc, n);
+    if(null_unite){
+        while(1){
+            p=scan::first_not_of(p, e, set);
+            if(p==e)
+                break;
+            const C* q=scan::first_of(p, e, set);
+            f(p, q);
+            p=q;
+        }
+    }
+    else{
+        while(1){
+            const C* q=scan::first_of(p, e, set);
+            f(p, q);
+            if(q==e)
+                break;
+            p=q+1;
+            if(p==e){
+                f(p, p);
                 break;
             }
-		}//while
-	}//else
+        }//while
+    }//else
+}
+
+template<typename C, typename X>
+typename std::enable_if<std::is_convertible<const X&, const C*>::value, size_t>::type
+    str_len(const X& s)
+{
+    return std::char_traits<C>::length(s);
+}
+
+template<typename C, typename X>
+auto str_len(const X& s) -> typename std::enable_if<
+        !std::is_convertible<const X&, const C*>::value, decltype(s.size())>::type
+{
+    return s.size();
+}
+
+template<typename C, typename S>
+void str_append(S& r, const C* x)
+{
+    r.append(x);
+}
+
+template<typename C, typename S, typename X>
+typename std::enable_if<!std::is_convertible<const X&, const C*>::value>::type
+    str_append(S& r, const X& x)
+{
+    r.append(x.data(), x.size());
+}
+
+// a single pass over input ranges
+template<typename C, typename S, typename I>
+void join_to(S& r, const C* sep, size_t n, I it, I end, std::input_iterator_tag)
+{
+    for(bool first=true; it!=end; ++it){
+        if(first)
+            first=false;
+        else
+            r.append(sep, n);
+        str_append<C>(r, *it);
+    }
+}
+
+// forward ranges are measured first, to reserve once
+template<typename C, typename S, typename I>
+void join_to(S& r, const C* sep, size_t n, I it, I end, std::forward_iterator_tag)
+{
+    size_t k=0, total=0;
+    for(I i=it; i!=end; ++i, ++k)
+        total+=str_len<C>(*i);
+    if(k==0)
+        return;
+    r.reserve(r.size()+total+n*(k-1));
+    join_to(r, sep, n, it, end, std::input_iterator_tag());
+}
+
+/** append items of a range to r, with sep between them.
+ */
+template<typename C, typename S, typename L>
+void join_to(S& r, const C* sep, size_t n, L&& l)
+{
+    auto it=std::begin(l);
+    auto end=std::end(l);
+    join_to(r, sep, n, it, end,
+            typename std::iterator_traits<decltype(it)>::iterator_category());
+}
+
+} // ns detail
+
+template<
+    class CharT,
+    class Traits = std::char_traits<CharT>,
+    class Allocator = smart_allocator<CharT>
+> class basic_string_;
+
+template<typename C, typename T> class split_range_;
+
+/** @addtogroup str
+ * @{
+ */
+
+template<typename string>string strip(const string& x)
+{
+    typedef typename string::value_type C;
+    typedef detail::str_scan<C> scan;
+    static const C ws[]={' ', '\t', '\n', '\r'};
+    typename scan::set_t spc(ws, 4);
+
+    const C* b=x.data();
+    const C* e=b+x.size();
+    const C* i=scan::first_not_of(b, e, spc);
+    if(i==e)
+        return string();
+    const C* j=scan::last_not_of(i, e, spc);
+    return x.substr(i-b, j-i+1);
+}
+
+/** split a string.
+ * @param r          the output string list, supporting clear() and push_back().
+ *                   Items are made from (begin, end) of chars, so a list of str_view
+ *                   gets views into s without copying any char.
+ * @param s          the input string
+ * @param spc        the delimiters
+ * @param null_unite -1: a.c.t. python depent on token, 0: false, 1: true
+ */
+template<typename string_list, typename string> void split(string_list& r, const string& s, string spc="", int null_unite=-1)
+{
+    typedef typename string::value_type C;
+    typedef typename string_list::value_type item_t;
+    r.clear();
+    detail::split_fields(s.data(), s.data()+s.size(), spc.data(), spc.size(), null_unite,
+        [&r](const C* p, const C* q){
+            r.push_back(item_t(p, q));
+        });
 }
 
 template<typename string_list, typename string>
@@ -144,26 +388,37 @@ template<typename string_list, typename string>
     return split(r, s, string(spc), null_unite);
 }
 
+namespace detail{
+
+// the string type joined from items of V
+template<typename V> struct join_t{
+    typedef V type;
+};
+
+template<typename C, typename T> struct join_t<basic_string_view_<C,T> >{
+    typedef basic_string_<C,T> type;
+};
+
+template<typename C> struct join_t<const C*>{
+    typedef basic_string_<C> type;
+};
+
+} // ns detail
+
 /** join a list of strings to one string.
+ * The lengths are summed first for lists and other forward ranges,
+ * so the result is allocated once.
  * @param token the delimiter
- * @param r     the input string list
- * @return the output string
+ * @param r     the input string list, or any range of strings
+ * @return the output string, of the item type, or basic_string_ for views
  */
 template<typename string_list>
-    typename string_list::value_type join(const char* token, const string_list& r)
+    typename detail::join_t<typename std::decay<string_list>::type::value_type>::type
+        join(const char* token, string_list&& r)
 {
-    if(r.empty()){
-        return "";
-    }
-    else{
-        typename string_list::const_iterator it=r.begin();
-        typename string_list::value_type res=*it;
-        ++it;
-        for(;it!=r.end();++it){
-            res+=token+*it;
-        }
-        return res;
-    }
+    typename detail::join_t<typename std::decay<string_list>::type::value_type>::type res;
+    detail::join_to(res, token, std::char_traits<char>::length(token), r);
+    return res;
 }
 
 /** test whether a string starts with a substring.
@@ -176,14 +431,67 @@ template<typename str1, typename str2> bool startswith(const str1& s,const str2&
     return boost::algorithm::starts_with(s, sub);
 }
 
+namespace detail{
+
+// strings taken as views of char by the fast paths of case-insensitive compare
+template<typename S>
+struct is_char_str:public std::is_convertible<const S&, str_view>
+{};
+
+template<typename str1, typename str2>
+bool istarts_with(const str1& s, const str2& sub, std::true_type)
+{
+    str_view a(s), b(sub);
+    return a.size()>=b.size() && str_scan<char>::iequal(a.data(), b.data(), b.size());
+}
+
+template<typename str1, typename str2>
+bool istarts_with(const str1& s, const str2& sub, std::false_type)
+{
+    return boost::algorithm::istarts_with(s, sub);
+}
+
+template<typename str1, typename str2>
+bool iends_with(const str1& s, const str2& sub, std::true_type)
+{
+    str_view a(s), b(sub);
+    return a.size()>=b.size() && str_scan<char>::iequal(a.end()-b.size(), b.data(), b.size());
+}
+
+template<typename str1, typename str2>
+bool iends_with(const str1& s, const str2& sub, std::false_type)
+{
+    return boost::algorithm::iends_with(s, sub);
+}
+
+template<typename str1, typename str2>
+bool iequals(const str1& s, const str2& x, std::true_type)
+{
+    str_view a(s), b(x);
+    return a.size()==b.size() && str_scan<char>::iequal(a.data(), b.data(), b.size());
+}
+
+template<typename str1, typename str2>
+bool iequals(const str1& s, const str2& x, std::false_type)
+{
+    return boost::algorithm::iequals(s, x);
+}
+
+template<typename str1, typename str2>
+struct is_char_strs:public std::integral_constant<bool, is_char_str<str1>::value && is_char_str<str2>::value>
+{};
+
+} // ns detail
+
 /** test whether a string starts with a substring case-insensitively.
+ * Strings of char are compared by SIMD in ASCII, and by the locale beyond.
  * @param s     the string
  * @param sub   the substring
  * @return true if matching
  */
 template<typename str1, typename str2> bool istartswith(const str1& s,const str2& sub)
 {
-    return boost::algorithm::istarts_with(s, sub);
+    return detail::istarts_with(s, sub, detail::is_char_strs<str1,str2>());
 }
 
 /** test whether a string ends with a substring.
@@ -197,15 +505,338 @@ template<typename str1, typename str2> bool endswith(const str1& s,const str2& s
 }
 
 /** test whether a string ends with a substring case-insensitively.
+ * Strings of char are compared by SIMD in ASCII, and by the locale beyond.
  * @param s     the string
  * @param sub   the substring
  * @return true if matching
  */
 template<typename str1, typename str2> bool iendswith(const str1& s,const str2& sub)
 {
-    return boost::algorithm::iends_with(s, sub);
+    return detail::iends_with(s, sub, detail::is_char_strs<str1,str2>());
+}
+
+/** test whether two strings are equal case-insensitively.
+ * @param s     the string
+ * @param x     the other string
+ * @return true if matching
+ */
+template<typename str1, typename str2> bool iequals(const str1& s,const str2& x)
+{
+    return detail::iequals(s, x, detail::is_char_strs<str1,str2>());
+}
+
+namespace detail{
+
+static constexpr const char digits_lower[]="0123456789abcdef";
+static constexpr const char digits_upper[]="0123456789ABCDEF";
+static constexpr const char digit_pairs[]=
+    "00010203040506070809101112131415161718192021222324252627282930313233343536373839"
+    "40414243444546474849505152535455565758596061626364656667686970717273747576777879"
+    "8081828384858687888990919293949596979899";
+
+/** write the digits of v in base 8, 10 or 16 to the end of [.., e).
+ * @return the first digit
+ */
+template<typename C>
+C* format_uint(C* e, unsigned long long v, unsigned base=10, bool upper=false)
+{
+    C* p=e;
+    if(base==10){
+        while(v>=100){
+            const char* d=digit_pairs+(v%100)*2;
+            v/=100;
+            *--p=C(d[1]);
+            *--p=C(d[0]);
+        }
+        if(v>=10){
+            const char* d=digit_pairs+v*2;
+            *--p=C(d[1]);
+            *--p=C(d[0]);
+        }
+        else
+            *--p=C('0'+v);
+    }
+    else{
+        const char* digits=(upper ? digits_upper : digits_lower);
+        unsigned shift=(base==16 ? 4 : 3);
+        unsigned long long mask=base-1;
+        do{
+            *--p=C(digits[v & mask]);
+            v>>=shift;
+        }while(v);
+    }
+    return p;
+}
+
+/** write v in decimal to the end of [.., e), with '-' if negative.
+ * @return the first char
+ */
+template<typename C>
+C* format_int(C* e, long long v)
+{
+    if(v>=0)
+        return format_uint(e, (unsigned long long)v);
+    C* p=format_uint(e, 0ULL-(unsigned long long)v);
+    *--p=C('-');
+    return p;
 }
 
+/** write x as %g does, i.e. as streams print doubles by default.
+ * It is exact with 128-bit integers for 1e-5<=|x|<1e15, and falls back to snprintf() otherwise.
+ * @param buf the output, of 32 chars at least
+ * @return the length
+ */
+inline int format_g(char* buf, double x)
+{
+#ifdef __SIZEOF_INT128__
+    typedef unsigned __int128 u128;
+    static const unsigned long long pow10[]={1ULL, 10ULL, 100ULL, 1000ULL, 10000ULL, 100000ULL,
+        1000000ULL, 10000000ULL, 100000000ULL, 1000000000ULL, 10000000000ULL, 100000000000ULL,
+        1000000000000ULL};
+    double a=std::fabs(x);
+    if(a>=1e-5 && a<1e15){
+        // a=m*2^e exactly, -69<=e<=-3
+        int e2;
+        unsigned long long m=(unsigned long long)std::ldexp(std::frexp(a, &e2), 53);
+        int e=e2-53;
+        // q=round(a*10^(5-E)) of 6 digits, E is the decimal exponent, guessed by e2
+        int E=((e2-1)*78913)>>18;
+        unsigned long long q;
+        bool up;
+        while(1){
+            int k=5-E;
+            if(k>=0){
+                // a*10^k=m*10^k/2^-e
+                u128 num=(u128)m*pow10[k];
+                q=(unsigned long long)(num>>(-e));
+                u128 rem=num&(((u128)1<<(-e))-1);
+                u128 half=(u128)1<<(-e-1);
+                up=(rem>half || (rem==half && (q&1)));
+            }
+            else{
+                // a/10^-k=m/(10^-k*2^-e), nested floors for no overflow
+                unsigned long long p10=pow10[-k];
+                q=(m>>(-e))/p10;
+                if(q<100000 || q>=1000000)
+                    up=false;
+                else{
+                    unsigned long long den=p10<<(-e);
+                    unsigned long long rem=m-q*den;
+                    up=(rem*2>den || (rem*2==den && (q&1))); // rem<den<=m/1e5, no overflow
+                }
+            }
+            if(q>=1000000){
+                E++;
+                continue;
+            }
+            if(q<100000){
+                E--;
+                continue;
+            }
+            if(up && ++q==1000000){ // to even as printf
+                q=100000;
+                E++;
+            }
+            break;
+        }
+        char digits[6];
+        for(int i=5; i>=0; i--, q/=10)
+            digits[i]=char('0'+q%10);
+        int n=6;
+        while(n>1 && digits[n-1]=='0')
+            n--;
+
+        char* p=buf;
+        if(x<0)
+            *p++='-';
+        if(E<-4 || E>=6){
+            *p++=digits[0];
+            if(n>1){
+                *p++='.';
+                for(int i=1; i<n; i++)
+                    *p++=digits[i];
+            }
+            *p++='e';
+            *p++=(E<0 ? '-' : '+');
+            int ae=(E<0 ? -E : E);
+            *p++=char('0'+ae/10);
+            *p++=char('0'+ae%10);
+        }
+        else if(E>=0){
+            for(int i=0; i<=E; i++)
+                *p++=digits[i];
+            if(n>E+1){
+                *p++='.';
+                for(int i=E+1; i<n; i++)
+                    *p++=digits[i];
+            }
+        }
+        else{
+            *p++='0';
+            *p++='.';
+            for(int i=E+1; i<0; i++)
+                *p++='0';
+            for(int i=0; i<n; i++)
+                *p++=digits[i];
+        }
+        return p-buf;
+    }
+#endif
+    return snprintf(buf, 32, "%g", x);
+}
+
+/** write x as streams print it by default.
+ * @param buf the output, of 32 chars at least
+ * @return the length
+ */
+inline int format_g(char* buf, long double x)
+{
+    return snprintf(buf, 32, "%Lg", x);
+}
+
+/** write the prefix of base before p, as set_base(s, base, true) does.
+ * @return the first char
+ */
+inline char* format_prefix(char* p, int base)
+{
+    switch(base){
+        case 8:
+            *--p='0';
+            break;
+        case 10:
+            break;
+        case 16:
+            *--p='x';
+            *--p='0';
+            break;
+        default:
+            PROTON_LOG(0, "unsupported base : " << base );
+    }
+    return p;
+}
+
+// integers handled by to_() and get_int() directly; streams treat chars and
+// bool in their own ways, so they are left to streams
+template<typename V>
+struct is_num_int:public std::integral_constant<bool, std::is_integral<V>::value
+    && !std::is_same<V, bool>::value && !std::is_same<V, char>::value
+    && !std::is_same<V, signed char>::value && !std::is_same<V, unsigned char>::value
+    && !std::is_same<V, wchar_t>::value && !std::is_same<V, char16_t>::value
+    && !std::is_same<V, char32_t>::value>
+{};
+
+// space chars in the "C" locale, skipped by streams before numbers
+inline bool is_num_space(char c)
+{
+    return c==' ' || (c>='\t' && c<='\r');
+}
+
+/** the value of a digit in base 16 and below, or 16 for others.
+ */
+inline unsigned digit_value(char c)
+{
+    if(c>='0' && c<='9')
+        return c-'0';
+    c|=0x20;
+    if(c>='a' && c<='f')
+        return c-'a'+10;
+    return 16;
+}
+
+/** parse all of [p,e) as an integer, as an istream does.
+ * Leading spaces and a sign are allowed, and "0x" in hex. For unsigned types
+ * '-' negates the value as strtoul() does.
+ * @param base 10 or 16
+ * @return false for bad chars, no digits, or a value out of the range of int_t
+ */
+template<typename int_t>
+bool parse_int(int_t& r, const char* p, const char* e, unsigned base)
+{
+    typedef typename std::make_unsigned<int_t>::type U;
+    while(p<e && is_num_space(*p))
+        ++p;
+    bool neg=false;
+    if(p<e && (*p=='-' || *p=='+')){
+        neg=(*p=='-');
+        ++p;
+    }
+    if(base==16 && e-p>2 && p[0]=='0' && (p[1]|0x20)=='x')
+        p+=2;
+    if(p==e)
+        return false;
+
+    U limit=std::numeric_limits<int_t>::max();
+    if(std::is_signed<int_t>::value && neg)
+        limit+=1;
+    U cut=limit/base;
+    unsigned cut_digit=limit%base;
+    U v=0;
+    for(; p<e; ++p){
+        unsigned d=digit_value(*p);
+        if(d>=base || v>cut || (v==cut && d>cut_digit))
+            return false;
+        v=v*base+d;
+    }
+    r=(int_t)(neg ? U(0)-v : v);
+    return true;
+}
+
+inline void parse_float(float& r, const char* s, char** e)
+{
+    r=strtof(s, e);
+}
+
+inline void parse_float(double& r, const char* s, char** e)
+{
+    r=strtod(s, e);
+}
+
+inline void parse_float(long double& r, const char* s, char** e)
+{
+    r=strtold(s, e);
+}
+
+/** parse all of [p,e) as a floating-point number, as an istream does.
+ * Only digits, signs, '.' and exponents are taken, so "inf", "nan" and hex
+ * floats are refused as streams do. The decimal point is of the C locale.
+ * @return false for bad chars or an overflow
+ */
+template<typename float_t>
+bool parse_float(float_t& r, const char* p, const char* e)
+{
+    while(p<e && is_num_space(*p))
+        ++p;
+    if(p==e)
+        return false;
+    for(const char* q=p; q<e; ++q){
+        if(!((*q>='0' && *q<='9') || *q=='.' || *q=='-' || *q=='+' || (*q|0x20)=='e'))
+            return false;
+    }
+    // strtod() needs a '\0', copied on the stack as numbers are short
+    char buf[128];
+    std::string big;
+    const char* s;
+    size_t n=e-p;
+    if(n<sizeof(buf)){
+        std::memcpy(buf, p, n);
+        buf[n]='\0';
+        s=buf;
+    }
+    else{
+        big.assign(p, n);
+        s=big.c_str();
+    }
+    char* end;
+    float_t x;
+    parse_float(x, s, &end);
+    if(end!=s+n || std::isinf(x))
+        return false;
+    r=x;
+    return true;
+}
+
+} // ns detail
+
 template<typename ostream> void set_base(ostream& s, int base, bool is_num=false)
 {
     switch(base){
@@ -227,20 +858,95 @@ template<typename ostream> void set_base(ostream& s, int base, bool is_num=false
     }
 }
 
+namespace detail{
+
+// to_() by streams, for objects
+template<typename string, typename T, typename X=void>
+struct to_string_t{
+    static string get(const T& n, int base)
+    {
+        std::basic_ostringstream<char, std::char_traits<char>, typename string::allocator_type > s;
+        set_base(s, base, true);
+        s << n;
+        return s.str();
+    }
+};
+
+template<typename string, typename T>
+struct to_string_t<string, T, typename std::enable_if<is_num_int<T>::value>::type>{
+    static string get(T n, int base)
+    {
+        typedef typename std::make_unsigned<T>::type U;
+        char buf[32];
+        char* e=buf+sizeof(buf);
+        char* p;
+        // streams print negative numbers in oct/hex as unsigned ones
+        if(base==8 || base==16)
+            p=format_uint(e, (unsigned long long)(U)n, base);
+        else if(std::is_signed<T>::value)
+            p=format_int(e, (long long)n);
+        else
+            p=format_uint(e, (unsigned long long)n);
+        p=format_prefix(p, base);
+        return string(p, e-p);
+    }
+};
+
+// the base only adds the prefix for floats, as in streams
+template<typename string, typename T>
+struct to_string_t<string, T, typename std::enable_if<std::is_floating_point<T>::value>::type>{
+    static string get(T n, int base)
+    {
+        typedef typename std::conditional<std::is_same<T, long double>::value, long double, double>::type F;
+        char buf[40];
+        int k=format_g(buf+2, (F)n);
+        char* p=format_prefix(buf+2, base);
+        return string(p, buf+2+k-p);
+    }
+};
+
+// get_int() by streams, for types other than integers
+template<typename int_t, typename X=void>
+struct get_int_t{
+    static bool get(int_t& r, const str_view& s, int base)
+    {
+        std::istringstream i(std::string(s.data(), s.size()));
+        int_t x;
+        if(base==16)
+            i >> std::hex;
+        if ( (!(i >> x)) || (i.get()>0) ){
+            return false;
+        }
+        r=x;
+        return true;
+    }
+};
+
+template<typename int_t>
+struct get_int_t<int_t, typename std::enable_if<is_num_int<int_t>::value>::type>{
+    static bool get(int_t& r, const str_view& s, int base)
+    {
+        return parse_int(r, s.begin(), s.end(), base);
+    }
+};
+
+} // ns detail
+
 /** convert a number/object to a string.
+ * Integers and floats are written without streams or heap use, other than
+ * the result; other types by their stream output.
  * @param n    the input value
- * @param base 10:dec, 16:hex
+ * @param base 10:dec, 16:hex with "0x", 8:oct with "0"
  * @return the output string
  */
 template<typename string, typename T> string to_(T&& n, int base=10)
 {
-    std::basic_ostringstream<char, std::char_traits<char>, typename string::allocator_type > s;
-    set_base(s, base, true);
-    s << n;
-    return s.str();
+    return detail::to_string_t<string, typename std::decay<T>::type>::get(n, base);
 }
 
 /** get integer (including int/long/unsigned and so on) from string.
+ * A "0x" prefix or an "h" suffix means hex. It parses chars in place, so s
+ * may be a str, a view or a C string.
  * @param r the output value
  * @param s the input string
  * @param base 10:dec, 16:hex
@@ -248,29 +954,55 @@ template<typename string, typename T> string to_(T&& n, int base=10)
  */
 template<typename int_t, typename string> bool get_int(int_t& r, const string& s, int base=10)
 {
-    bool is_hex= (base==16);
-    string v1;
-    if( iendswith(s,"h") ){
-        v1=s.substr(0,s.length()-1);
-        is_hex=true;
+    str_view v(s);
+    if( !v.empty() && (v.back()|0x20)=='h' ){
+        v.remove_suffix(1);
+        base=16;
     }
-    else if( istartswith(s,"0x") ){
-        v1=s;
-        is_hex=true;
+    else if( v.size()>=2 && v[0]=='0' && (v[1]|0x20)=='x' ){
+        base=16;
     }
-    else{
-        v1=s;
-    }
-    std::basic_istringstream<char, std::char_traits<char>, typename string::allocator_type >
-        i(v1);
-    int_t x;
-    if(is_hex)
-        i >> std::hex;
-    if ( (!(i >> x)) || (i.get()>0) ){
-        return false;
+    else if( base!=16 ){
+        base=10;
     }
-    r=x;
-    return true;
+    return detail::get_int_t<int_t>::get(r, v, base);
+}
+
+/** get a float/double/long double from string, as streams read it.
+ * @param r the output value
+ * @param s the input string
+ * @return true: success, false: failure
+ */
+template<typename float_t, typename string> bool get_float(float_t& r, const string& s)
+{
+    str_view v(s);
+    return detail::parse_float(r, v.begin(), v.end());
+}
+
+/** convert a string to lower case in place.
+ * ASCII letters are converted by SIMD, other chars by the global locale.
+ * @param s the string
+ * @return s
+ */
+template<typename string> string& to_lower_inplace(string& s)
+{
+    typedef typename string::value_type C;
+    if(!s.empty())
+        detail::str_scan<C>::convert_case(&*s.begin(), s.data(), s.data()+s.size(), false);
+    return s;
+}
+
+/** convert a string to upper case in place.
+ * ASCII letters are converted by SIMD, other chars by the global locale.
+ * @param s the string
+ * @return s
+ */
+template<typename string> string& to_upper_inplace(string& s)
+{
+    typedef typename string::value_type C;
+    if(!s.empty())
+        detail::str_scan<C>::convert_case(&*s.begin(), s.data(), s.data()+s.size(), true);
+    return s;
 }
 
 /** get a lower-case copy from string.
@@ -279,26 +1011,9 @@ template<typename int_t, typename string> bool get_int(int_t& r, const string& s
  */
 template<typename string> string to_lower(const string& s)
 {
- 	long length = s.size();
-    static typename string::allocator_type alloc;
-    char* p = alloc.allocate(length);
-    if(p){
-        char* q = p;
-	    const char* p0 = s.c_str();
-	    string r;
-
-	    for(long i=0;i<length;++i){
-		    *p=tolower(*p0);
-            p++;
-            p0++;
-	    }
-	    r = string(q,length);
-	    alloc.deallocate(q,length) ;
-	    return r;
-    }
-    else{
-        PROTON_ERR("bad alloc:" << length);
-    }
+    string r(s);
+    to_lower_inplace(r);
+    return r;
 }
 
 /** get a upper-case copy from string.
@@ -307,27 +1022,9 @@ template<typename string> string to_lower(const string& s)
  */
 template<typename string>string to_upper(const string& s)
 {
- 	long length = s.size();
-    static typename string::allocator_type alloc;
-    char* p = alloc.allocate(length);
-    if(p){
-        char* q = p;
-	    const char* p0 = s.c_str();
-	    string r;
-
-	    for(long i=0;i<length;++i){
-		    *p=toupper(*p0);
-            p++;
-            p0++;
-	    }
-	    r = string(q,length);
-	    alloc.deallocate(q,length) ;
-
-	    return r;
-    }
-    else{
-        PROTON_ERR("bad alloc:" << length);
-    }
+    string r(s);
+    to_upper_inplace(r);
+    return r;
 }
 
 /** get a char from a string at a given index.
@@ -392,241 +1089,371 @@ std::basic_string<C,T,A> sub(const std::basic_string<C,T,A>& x, long first, long
     return x.substr(first,last-first);
 }
 
-template<
-    class CharT,
-    class Traits = std::char_traits<CharT>,
-    class Allocator = smart_allocator<CharT>
-> class basic_string_;
 
 namespace detail{
 
-template<typename C, typename T>
-void output_prefix(std::basic_ostream<C,T>& o, const C*& f)
-{
-    if(f==NULL)
-        return;
-    while(1){
-        const C* p=vals<C>::find(f, *vals<C>::per);
-        if(p){
-            switch(*(p+1)){
-            case 0:
-                throw std::invalid_argument("incomplete format");
-            case *vals<C>::per:
-                o.write(f, p-f+1);
-                f=p+2;
-                continue;
-            default:
-                o.write(f,p-f);
-                f=p+1;
+// the format engine of %.
+// Python % semantics with conversions of one char: %s, %f, %d, %u, %o, %x, %X and %%.
+// The text and arguments are written straight into the result, reserved once,
+// and numbers are converted without streams.
+
+// the output of %, gathered in a buffer on the stack and moved to the result in
+// blocks, so a short result is allocated once in its exact size
+template<typename C, typename S>
+class format_writer{
+protected:
+    static constexpr size_t buf_size=256;
+
+    S& _r;
+    const C* _f;
+    size_t _hint;
+    size_t _n;
+    C _buf[buf_size];
+
+    void flush()
+    {
+        if(_r.empty())
+            _r.reserve(std::max(_hint, _n));
+        _r.append(_buf, _n);
+        _n=0;
+    }
+
+public:
+    /** ctor.
+     * @param r the result
+     * @param f the format
+     * @param hint the estimated size of the result, reserved if it is long
+     */
+    format_writer(S& r, const C* f, size_t hint):_r(r), _f(f), _hint(hint), _n(0)
+    {}
+
+    void append(const C* s, size_t n)
+    {
+        if(_n+n>buf_size){
+            flush();
+            if(n>buf_size){
+                _r.append(s, n);
                 return;
-            }//switch
+            }
         }
-        else{
-            o << f;
-            f=NULL;
-            return;
+        std::char_traits<C>::copy(_buf+_n, s, n);
+        _n+=n;
+    }
+
+    void append(const C* s)
+    {
+        append(s, std::char_traits<C>::length(s));
+    }
+
+    void push_back(C c)
+    {
+        if(_n==buf_size)
+            flush();
+        _buf[_n++]=c;
+    }
+
+    /** write the text before the next conversion.
+     * @return the conversion char, or 0 at the end of the format
+     */
+    C next_conv()
+    {
+        if(_f==NULL)
+            return 0;
+        const C* p=_f;
+        while(1){
+            if(*p==0){
+                append(_f, p-_f);
+                _f=NULL;
+                return 0;
+            }
+            if(*p==*vals<C>::per){
+                switch(p[1]){
+                case 0:
+                    throw std::invalid_argument("incomplete format");
+                case *vals<C>::per:
+                    append(_f, p-_f+1);
+                    _f=p+2;
+                    p=_f;
+                    continue;
+                default:
+                    append(_f, p-_f);
+                    _f=p+2;
+                    return p[1];
+                }//switch
+            }
+            ++p;
         }
     }
-}
 
-template<typename C, typename T, typename V, typename X>
-struct format_t;
+    /** write the text before the conversion of the next argument.
+     */
+    C next()
+    {
+        C c=next_conv();
+        if(c==0)
+            throw std::invalid_argument("not all arguments converted during formatting");
+        return c;
+    }
 
-template<typename C, typename T, typename V>
-struct format_t<C,T,V,
-            typename std::enable_if<
-                std::is_integral<V>::value &&
-                sizeof(typename std::remove_reference<V>::type)==1,
-            void>::type
-        >
-{
-    static void output(V a, std::basic_ostream<C,T>& o, const C* & f)
+    /** write the text after the last argument, and move all to the result.
+     */
+    void finish()
+    {
+        if(next_conv()!=0)
+            throw std::invalid_argument("not enough arguments for format");
+        if(_r.empty())
+            _r.assign(_buf, _n);
+        else
+            _r.append(_buf, _n);
+    }
+};
+
+// integers, printed as numbers for all conversions; chars of 1 byte as int
+template<typename V>
+struct is_format_int:public std::integral_constant<bool, std::is_integral<V>::value
+    && !std::is_same<V, wchar_t>::value && !std::is_same<V, char16_t>::value
+    && !std::is_same<V, char32_t>::value>
+{};
+
+// strings of C, written as they are
+template<typename C, typename V, typename X=void>
+struct is_format_str:public std::false_type
+{};
+
+template<typename C, typename V>
+struct is_format_str<C, V, typename std::enable_if<
+        std::is_same<typename V::traits_type::char_type, C>::value,
+        decltype((void)std::declval<const V&>().data(), (void)std::declval<const V&>().size())
+    >::type>:public std::true_type
+{};
+
+template<typename C, typename V, typename X=void>
+struct format_arg;
+
+template<typename C, typename V>
+struct format_arg<C, V, typename std::enable_if<is_format_int<V>::value>::type>{
+    typedef typename std::conditional<sizeof(V)==1, int, V>::type P; // as streams print them
+    typedef typename std::make_unsigned<P>::type U;
+
+    static size_t size(V a)
+    {
+        return 24;
+    }
+
+    template<typename W>
+    static void write(W& r, V a, C conv)
     {
-        bool printed=false;
-        output_prefix(o,f);
-        if(f==NULL)
-            throw std::invalid_argument("not all arguments converted during formatting");
-        switch(*(f)){
+        C buf[32];
+        C* e=buf+32;
+        C* p;
+        switch(conv){
             case *vals<C>::s:
             case *vals<C>::f:
             case *vals<C>::d:
             case *vals<C>::u:
-                o << std::dec << int(a);
+                if(std::is_signed<P>::value)
+                    p=format_int(e, (long long)(P)a);
+                else
+                    p=format_uint(e, (unsigned long long)(P)a);
                 break;
             case *vals<C>::o:
-                o << std::oct << int(a);
+                p=format_uint(e, (unsigned long long)(U)(P)a, 8);
                 break;
             case *vals<C>::x:
-                o << std::hex << std::nouppercase << int(a);
+                p=format_uint(e, (unsigned long long)(U)(P)a, 16);
                 break;
             case *vals<C>::X:
-                o << std::hex << std::uppercase << int(a);
+                p=format_uint(e, (unsigned long long)(U)(P)a, 16, true);
                 break;
             default:
                 throw std::invalid_argument("unsupported format character");
-        }//inner switch
-        f++;
+        }//switch
+        r.append(p, e-p);
     }
 };
 
-template<typename C, typename T, typename V>
-struct format_t<C,T,V,
-            typename std::enable_if<
-                std::is_integral<V>::value &&
-                sizeof(typename std::remove_reference<V>::type)!=1,
-            void>::type
-        >
-{
-    static void output(V a, std::basic_ostream<C,T>& o, const C* & f)
+template<typename C, typename V>
+struct format_arg<C, V, typename std::enable_if<std::is_floating_point<V>::value>::type>{
+    static size_t size(V a)
     {
-        bool printed=false;
-        output_prefix(o,f);
-        if(f==NULL)
-            throw std::invalid_argument("not all arguments converted during formatting");
-        switch(*(f)){
+        return 24;
+    }
+
+    template<typename W>
+    static void write(W& r, V a, C conv)
+    {
+        switch(conv){
             case *vals<C>::s:
             case *vals<C>::f:
+            {
+                char buf[64];
+                typedef typename std::conditional<std::is_same<V, long double>::value, long double, double>::type F;
+                int n=format_g(buf, (F)a); // as streams print them by default
+                for(int i=0; i<n; i++)
+                    r.push_back(C(buf[i]));
+                break;
+            }
             case *vals<C>::d:
             case *vals<C>::u:
-                o << std::dec << a;
-                break;
             case *vals<C>::o:
-                o << std::oct << a;
-                break;
             case *vals<C>::x:
-                o << std::hex << std::nouppercase << a;
-                break;
             case *vals<C>::X:
-                o << std::hex << std::uppercase << a;
+                format_arg<C, long long>::write(r, (long long)a, conv);
                 break;
             default:
                 throw std::invalid_argument("unsupported format character");
-        }//inner switch
-        f++;
+        }//switch
     }
 };
 
-template<typename C, typename T, typename V>
-struct format_t<C,T,V,typename std::enable_if<std::is_floating_point<V>::value, void>::type>
+template<typename C>
+void check_str_conv(C conv)
 {
-    static void output(V a, std::basic_ostream<C,T>& o, const C* & f)
+    switch(conv){
+        case *vals<C>::s:
+            return;
+        case *vals<C>::d:
+        case *vals<C>::u:
+        case *vals<C>::o:
+        case *vals<C>::x:
+        case *vals<C>::X:
+            throw std::invalid_argument("a number is required");
+        default:
+            throw std::invalid_argument("unsupported format character");
+    }//switch
+}
+
+template<typename C, typename V>
+struct format_arg<C, V, typename std::enable_if<is_format_str<C,V>::value>::type>{
+    static size_t size(const V& a)
     {
-        bool printed=false;
-        output_prefix(o,f);
-        if(f==NULL)
-            throw std::invalid_argument("not all arguments converted during formatting");
-        switch(*(f)){
-            case *vals<C>::s:
-            case *vals<C>::f:
-                o << std::dec << a;
-                break;
-            case *vals<C>::d:
-            case *vals<C>::u:
-                o << std::dec << (long long)(a);
-                break;
-            case *vals<C>::o:
-                o << std::oct << (long long)(a);
-                break;
-            case *vals<C>::x:
-                o << std::hex << std::nouppercase << (long long)(a);
-                break;
-            case *vals<C>::X:
-                o << std::hex << std::uppercase << (long long)(a);
-                break;
-            default:
-                throw std::invalid_argument("unsupported format character");
-        }//inner switch
-        f++;
+        return a.size();
+    }
+
+    template<typename W>
+    static void write(W& r, const V& a, C conv)
+    {
+        check_str_conv(conv);
+        r.append(a.data(), a.size());
     }
 };
 
+template<typename C, typename V>
+struct format_arg<C, V, typename std::enable_if<!is_format_str<C,V>::value
+        && std::is_convertible<const V&, const C*>::value>::type>{
+    static size_t size(const V& a)
+    {
+        return 16;
+    }
 
-template<typename C, typename T, typename V>
-struct format_t<C,T,V,typename std::enable_if<!(std::is_floating_point<V>::value ||
-                                                std::is_integral<V>::value), void>::type>{
-    static void output(const V& a, std::basic_ostream<C,T>& o, const C* & f)
+    template<typename W>
+    static void write(W& r, const V& a, C conv)
     {
-        bool printed=false;
-        output_prefix(o,f);
-        if(f==NULL)
-            throw std::invalid_argument("not all arguments converted during formatting");
-        switch(*(f)){
-            case *vals<C>::s:
-                o << a;
-                break;
-            case *vals<C>::d:
-            case *vals<C>::u:
-            case *vals<C>::o:
-            case *vals<C>::x:
-            case *vals<C>::X:
-                throw std::invalid_argument("a number is required");
-            default:
-                throw std::invalid_argument("unsupported format character");
-        }//inner switch
-        f++;
+        check_str_conv(conv);
+        const C* s=a;
+        if(s)
+            r.append(s);
     }
 };
 
-template<typename C, typename T, typename V>
-struct format_output_t{
-    static void output(std::basic_ostream<C,T>& s, const C* f, const V& v)
+// others by their stream output
+template<typename C, typename V>
+struct format_arg<C, V, typename std::enable_if<!is_format_int<V>::value
+        && !std::is_floating_point<V>::value && !is_format_str<C,V>::value
+        && !std::is_convertible<const V&, const C*>::value>::type>{
+    static size_t size(const V& a)
     {
-        format_t<C,T,V,void>::output(v, s, f);
-        output_prefix(s, f);
-        if(f)
-            throw std::invalid_argument("not enough arguments for format");
+        return 16;
+    }
+
+    template<typename W>
+    static void write(W& r, const V& a, C conv)
+    {
+        check_str_conv(conv);
+        std::basic_ostringstream<C> o;
+        o << a;
+        const std::basic_string<C>& s=o.str();
+        r.append(s.data(), s.size());
     }
 };
 
-template<typename C, typename T, typename A, typename V>
-    basic_string_<C,T,A> str_format(const C* f, const V& v)
+template<typename C, typename W, typename V>
+void format_one(W& w, const V& a)
 {
-    std::basic_ostringstream<C,T,A> o;
-    format_output_t<C,T,V>::output(o, f, v);
-    return o.str();
+    C conv=w.next();
+    format_arg<C,V>::write(w, a, conv);
 }
 
-// helper function to format a tuple of any size
-template<typename C, typename T, typename V, long I>
-struct format_tuple {
-    static inline void output(std::basic_ostream<C,T>& s, const C* & f, const V& t)
+template<size_t I, size_t N>
+struct format_each{
+    template<typename C, typename W, typename V>
+    static void write(W& w, const V& t)
     {
-        typedef decltype(at<-I>(t)) N;
-        typedef typename std::remove_reference<N>::type N1;
-        format_t<C,T,N1,void>::output(at<-I>(t), s, f);
-        format_tuple<C, T, V, I-1>::output(s, f, t);
+        format_one<C>(w, std::get<I>(t));
+        format_each<I+1, N>::template write<C>(w, t);
+    }
+
+    template<typename C, typename V>
+    static size_t size(const V& t)
+    {
+        typedef typename std::decay<typename std::tuple_element<I, V>::type>::type A;
+        return format_arg<C,A>::size(std::get<I>(t))+format_each<I+1, N>::template size<C>(t);
     }
 };
 
-template<typename C, typename T, typename V>
-struct format_tuple<C, T, V, 1> {
-    static inline void output(std::basic_ostream<C,T>& s, const C* & f, const V& t)
+template<size_t N>
+struct format_each<N, N>{
+    template<typename C, typename W, typename V>
+    static void write(W& w, const V& t)
+    {}
+
+    template<typename C, typename V>
+    static size_t size(const V& t)
     {
-        typedef decltype(at<-1>(t)) N;
-        typedef typename std::remove_reference<N>::type N1;
-        format_t<C,T,N1,void>::output(at<-1>(t), s, f);
+        return 0;
     }
 };
 
-template<typename C, typename T, typename V>
-struct format_tuple<C, T, V, 0> {
-    static inline void output(std::basic_ostream<C,T>& s, const C* & f, const V& t)
+// a single argument
+template<typename C, typename V>
+struct format_args{
+    static size_t size(const V& v)
+    {
+        return format_arg<C,V>::size(v);
+    }
+
+    template<typename W>
+    static void write(W& w, const V& v)
     {
-    	// [FIXME] output the string anyway? or throw an err?
+        format_one<C>(w, v);
     }
 };
 
-template<typename C, typename T, typename ...V>
-struct format_output_t<C,T,std::tuple<V...> >{
-    static void output(std::basic_ostream<C,T>& s, const C* f, const std::tuple<V...> & t)
+// arguments in a tuple
+template<typename C, typename ...V>
+struct format_args<C, std::tuple<V...> >{
+    static size_t size(const std::tuple<V...>& t)
     {
-        format_tuple<C, T, const std::tuple<V...> &, sizeof...(V) >::output(s,f,t);
-        detail::output_prefix(s, f);
-        if(f)
-            throw std::invalid_argument("not enough arguments for format");
+        return format_each<0, sizeof...(V)>::template size<C>(t);
+    }
+
+    template<typename W>
+    static void write(W& w, const std::tuple<V...>& t)
+    {
+        format_each<0, sizeof...(V)>::template write<C>(w, t);
     }
 };
 
+template<typename C, typename T, typename A, typename V>
+    basic_string_<C,T,A> str_format(const C* f, const V& v)
+{
+    basic_string_<C,T,A> r;
+    format_writer<C, basic_string_<C,T,A> > w(r, f, T::length(f)+format_args<C,V>::size(v));
+    format_args<C,V>::write(w, v);
+    w.finish();
+    return r;
+}
+
 } //ns detail
 
 
@@ -654,6 +1481,7 @@ class basic_string_ : public std::basic_string<CharT,Traits,Allocator> {
 public:
     typedef std::basic_string<CharT,Traits,Allocator> baseT;
     typedef typename baseT::difference_type offset_t;
+    typedef basic_string_view_<CharT,Traits> view_t;
 protected:
     offset_t __offset(offset_t i)const
     {
@@ -682,6 +1510,17 @@ protected:
         return begin;
     }
 
+    template<typename X> void append_(const X& x)
+    {
+        this->append(x);
+    }
+
+    // views are appended without a temporary string
+    void append_(const view_t& x)
+    {
+        this->append(x.data(), x.size());
+    }
+
     void fix_range(offset_t& begin, offset_t& end)const
     {
         offset_t size=(offset_t)this->size(); //[FIXME] size>2G in 32bit?
@@ -716,13 +1555,13 @@ public:
 
     /** move ctor.
      */
-    basic_string_(basic_string_&& x)noexcept:baseT(x)
+    basic_string_(basic_string_&& x)noexcept:baseT(std::move(x))
     {}
 
     explicit basic_string_(const baseT& x):baseT(x)
     {}
 
-    basic_string_(baseT&& x)noexcept:baseT(x)
+    basic_string_(baseT&& x)noexcept:baseT(std::move(x))
     {}
 
     /** assign.
@@ -735,7 +1574,7 @@ public:
 
     basic_string_& operator=(basic_string_&& x)noexcept
     {
-        baseT::operator=(x);
+        baseT::operator=(std::move(x));
         return *this;
     }
 
@@ -747,7 +1586,7 @@ public:
 
     basic_string_& operator=(baseT&& x)noexcept
     {
-        baseT::operator=(x);
+        baseT::operator=(std::move(x));
         return *this;
     }
 
@@ -768,22 +1607,23 @@ public:
     template<typename argT>
     basic_string_& operator+=(argT&& a)
     {
-        this->append(a);
+        append_(a);
         return *this;
     }
 
     /** string + string
      */
     template<typename argT>
-    basic_string_ operator+(argT&& a)
+    basic_string_ operator+(argT&& a)const
     {
-        basic_string_ r(*this);
-        r.append(a);
+        basic_string_ r;
+        r.reserve(this->size()+detail::str_len<CharT>(a));
+        r.append(*this);
+        r.append_(a);
         return r;
     }
 
     /** string % V
-     * [TODO] optimization to remove the temporary ostringstream buffer
      */
     template<typename V>
     basic_string_ operator%(const V& a)const
@@ -850,11 +1690,34 @@ public:
         return r;
     }
 
+    /** a view of [i:], like operator()(i) without copying chars.
+     */
+    view_t view(offset_t i)const
+    {
+        return view_t(this->data()+fix_offset(i), this->data()+this->size());
+    }
+
+    /** a view of [i:j], like operator()(i,j) without copying chars.
+     */
+    view_t view(offset_t i, offset_t j)const
+    {
+        fix_range(i,j);
+        return view_t(this->data()+i, this->data()+j);
+    }
+
+    /** a view of [i:j:k], every k-th char, see slice_.
+     */
+    slice_<const CharT*> view(offset_t i, offset_t j, size_t k)const
+    {
+        fix_range(i,j);
+        return slice_<const CharT*>::of(this->data()+i, this->data()+j, k);
+    }
+
     /** total number of occurences of a char.
      */
     size_t count(const CharT& x)const
     {
-        return std::count(this->begin(), this->end(), x);
+        return detail::str_scan<CharT>::count(this->data(), this->data()+this->size(), x);
     }
 
     /** index of the first occurence of a char.
@@ -863,8 +1726,9 @@ public:
      */
     offset_t index(const CharT& val)const
     {
-        auto begin=this->begin(), end=this->end();
-        auto it=std::find(begin, end, val);
+        const CharT* begin=this->data();
+        const CharT* end=begin+this->size();
+        const CharT* it=detail::str_scan<CharT>::find(begin, end, val);
         if(it==end)
             throw std::invalid_argument("The given char doesn't exist in this sequence.");
         return it-begin;
@@ -876,13 +1740,15 @@ public:
      */
     basic_string_ strip(const baseT& spc=detail::vals<CharT>::ws)const
     {
-        offset_t i=this->find_first_not_of(spc);
-        offset_t j=this->find_last_not_of(spc);
-
-        if(i<0 || j<0 || j < i )
+        typedef detail::str_scan<CharT> scan;
+        typename scan::set_t set(spc.data(), spc.size());
+        const CharT* b=this->data();
+        const CharT* e=b+this->size();
+        const CharT* i=scan::first_not_of(b, e, set);
+        if(i==e)
             return detail::vals<CharT>::nil_();
-
-        return basic_string_(this->begin()+i,this->begin()+j+1);
+        const CharT* j=scan::last_not_of(i, e, set);
+        return basic_string_(i, j+1);
     }
 
     /** split a string.
@@ -891,77 +1757,70 @@ public:
      * @return the output string list, in deque_<basic_string_>
      */
     deque_<basic_string_ >
-        split(const baseT& delim=baseT(), int null_unite=-1)const
+        split(const view_t& delim=view_t(), int null_unite=-1)const
     {
-        long pos = 0, begin, end;
-
         deque_<basic_string_> r;
+        detail::split_fields(this->data(), this->data()+this->size(), delim.data(), delim.size(), null_unite,
+            [&r](const CharT* p, const CharT* q){
+                r.push_back(basic_string_(p, q));
+            });
+        return r;
+    }
 
-        basic_string_ spc(delim);
-        if(spc.size()==0){
-            if(null_unite<0)
-                null_unite=1;
-            spc=detail::vals<CharT>::ws_();
-        }
-        else{
-            if(null_unite<0)
-                null_unite=0;
-        }
-
-        if(null_unite){
-            do{
-                begin = this->find_first_not_of(spc,pos);
-                if(begin<0)
-                    break;
-                end = this->find_first_of(spc,begin);
-                if(end<0)
-                    end=this->length();
-                r.push_back(this->substr(begin, end-begin));
-                pos = end;
-            }
-            while(pos < (long)this->length());
-        }
-        else{
-            while(1){
-                begin = this->find_first_of(spc,pos);
-                if(begin<0){
-                    r.push_back(this->substr(pos));
-                    break;
-                }
-                r.push_back(this->substr(pos, begin-pos));
-                pos = begin + 1;
-                if(pos>=(long)this->length()){
-                    r.push_back(detail::vals<CharT>::nil_());
-                    break;
-                }
-            }//while
-        }//else
+    /** split a string into views of it, as split() does but without copying chars.
+     * The views are valid until this string is changed or destroyed.
+     * @param delim        the delimiters
+     * @param null_unite -1: a.c.t. python depent on token, 0: false, 1: true
+     * @return the views in vector_<view_t>
+     */
+    vector_<view_t> split_view(const view_t& delim=view_t(), int null_unite=-1)const
+    {
+        vector_<view_t> r;
+        tokenize(r, delim, null_unite);
         return r;
     }
 
+    /** split a string into views of it, reusing the storage of a list.
+     * Once r has grown big enough, splitting does no heap allocation at all,
+     * which makes it the way to parse lines in a loop.
+     * @param r            the output views, supporting clear() and push_back()
+     * @param delim        the delimiters
+     * @param null_unite -1: a.c.t. python depent on token, 0: false, 1: true
+     * @return the number of views
+     */
+    template<typename view_list>
+        size_t tokenize(view_list& r, const view_t& delim=view_t(), int null_unite=-1)const
+    {
+        r.clear();
+        detail::split_fields(this->data(), this->data()+this->size(), delim.data(), delim.size(), null_unite,
+            [&r](const CharT* p, const CharT* q){
+                r.push_back(view_t(p, q));
+            });
+        return r.size();
+    }
+
     /** join a list of strings to one string.
-     * @param r     the input string list
+     * @param r     the input string list, or any range of strings, like isplit()
      * @return the output string
      */
     template<typename string_list>
-        basic_string_ join(const string_list& r)const
+        basic_string_ join(string_list&& r)const
     {
-        if(len(r)==0){
-            return basic_string_();
-        }
-        else{
-            bool first=true;
-            basic_string_ res;
-            for(auto i : r){
-                if(first){
-                    first=false;
-                }
-                else
-                    res+=*this;
-                res+=i;
-            }
-            return res;
-        }
+        basic_string_ res;
+        detail::join_to(res, this->data(), this->size(), r);
+        return res;
+    }
+
+    /** split a string lazily, as split() does.
+     * Fields are views made on demand while iterating, so breaking early
+     * skips the rest of the string. The range refers to this string.
+     * @param delim        the delimiters
+     * @param null_unite -1: a.c.t. python depent on token, 0: false, 1: true
+     * @return the range of views
+     */
+    split_range_<CharT,Traits> isplit(const view_t& delim=view_t(), int null_unite=-1)const
+    {
+        return split_range_<CharT,Traits>(*this, delim, null_unite);
     }
 
     /** startswith.
@@ -975,7 +1834,7 @@ public:
      */
     template<typename str2> bool istartswith(str2&& sub)const
     {
-        return boost::algorithm::istarts_with(*this, sub);
+        return proton::istartswith(*this, sub);
     }
 
     /** endswith.
@@ -989,24 +1848,329 @@ public:
      */
     template<typename str2> bool iendswith(str2&& sub)const
     {
-        return boost::algorithm::iends_with(*this, sub);
+        return proton::iendswith(*this, sub);
+    }
+
+    /** case-insensitive ==.
+     */
+    template<typename str2> bool iequals(str2&& x)const
+    {
+        return proton::iequals(*this, x);
     }
 
     /** return a copy with upper case letters converted to lower case.
      */
     basic_string_ lower()const
     {
-        return boost::algorithm::to_lower_copy(*this);
+        return to_lower(*this);
     }
 
     /** return a copy with lower case letters converted to upper case.
      */
     basic_string_ upper()const
     {
-        return boost::algorithm::to_upper_copy(*this);
+        return to_upper(*this);
+    }
+};
+
+/** a lazy split() over chars, see basic_string_::isplit().
+ * It is a forward range of views, and refers to the chars split.
+ */
+template<typename C, typename T=std::char_traits<C> >
+class split_range_ {
+public:
+    typedef basic_string_view_<C,T> view_t;
+    typedef view_t value_type;
+    typedef typename detail::str_scan<C> scan;
+
+    class iterator{
+    friend class split_range_;
+    public:
+        typedef std::forward_iterator_tag iterator_category;
+        typedef view_t value_type;
+        typedef ptrdiff_t difference_type;
+        typedef const view_t* pointer;
+        typedef const view_t& reference;
+
+    protected:
+        const split_range_* _r;
+        view_t _v;
+
+        void next(const C* p)
+        {
+            const C* e=_r->_e;
+            if(_r->_unite){
+                p=scan::first_not_of(p, e, _r->_set);
+                if(p==e){
+                    _r=NULL;
+                    _v=view_t();
+                    return;
+                }
+            }
+            _v=view_t(p, scan::first_of(p, e, _r->_set));
+        }
+
+    public:
+        iterator():_r(NULL)
+        {}
+
+        const view_t& operator*()const
+        {
+            return _v;
+        }
+
+        const view_t* operator->()const
+        {
+            return &_v;
+        }
+
+        iterator& operator++()
+        {
+            const C* q=_v.end();
+            if(_r->_unite)
+                next(q);
+            else if(q==_r->_e){
+                _r=NULL;
+                _v=view_t();
+            }
+            else
+                next(q+1);
+            return *this;
+        }
+
+        iterator operator++(int)
+        {
+            iterator r=*this;
+            ++*this;
+            return r;
+        }
+
+        bool operator==(const iterator& x)const
+        {
+            return _r==x._r && _v.data()==x._v.data();
+        }
+
+        bool operator!=(const iterator& x)const
+        {
+            return !(*this==x);
+        }
+    };
+    typedef iterator const_iterator;
+
+protected:
+    const C* _b;
+    const C* _e;
+    typename scan::set_t _set;
+    bool _unite;
+
+    static typename scan::set_t make_set(const view_t& delim, int& null_unite)
+    {
+        const C* spc=delim.data();
+        size_t n=delim.size();
+        detail::split_args(spc, n, null_unite);
+        return typename scan::set_t(spc, n);
+    }
+
+public:
+    /** a range of fields in s.
+     * Up to 16 delimiters are copied, more are referred to.
+     */
+    split_range_(const view_t& s, const view_t& delim=view_t(), int null_unite=-1):
+        _b(s.data()), _e(s.data()+s.size()), _set(make_set(delim, null_unite)), _unite(null_unite)
+    {}
+
+    iterator begin()const
+    {
+        iterator it;
+        it._r=this;
+        it.next(_b);
+        return it;
+    }
+
+    iterator end()const
+    {
+        return iterator();
+    }
+
+    /** the number of fields, by splitting.
+     */
+    size_t size()const
+    {
+        size_t n=0;
+        for(iterator it=begin(); it!=end(); ++it)
+            n++;
+        return n;
+    }
+
+    bool empty()const
+    {
+        return begin()==end();
+    }
+};
+
+/** a lazy split() over a stream, see isplit().
+ * It is an input range of fields, which are read on demand into a buffer
+ * reused by all fields, so a field is valid until the next one is read.
+ */
+template<typename C, typename T=std::char_traits<C> >
+class stream_split_range_ {
+public:
+    typedef basic_string_<C,T> string_t;
+    typedef basic_string_view_<C,T> view_t;
+    typedef string_t value_type;
+    typedef typename detail::str_scan<C> scan;
+
+    class iterator{
+    friend class stream_split_range_;
+    public:
+        typedef std::input_iterator_tag iterator_category;
+        typedef string_t value_type;
+        typedef ptrdiff_t difference_type;
+        typedef const string_t* pointer;
+        typedef const string_t& reference;
+
+    protected:
+        stream_split_range_* _r;
+
+    public:
+        iterator():_r(NULL)
+        {}
+
+        const string_t& operator*()const
+        {
+            return _r->_field;
+        }
+
+        const string_t* operator->()const
+        {
+            return &_r->_field;
+        }
+
+        iterator& operator++()
+        {
+            if(!_r->next())
+                _r=NULL;
+            return *this;
+        }
+
+        bool operator==(const iterator& x)const
+        {
+            return _r==x._r;
+        }
+
+        bool operator!=(const iterator& x)const
+        {
+            return _r!=x._r;
+        }
+    };
+    typedef iterator const_iterator;
+
+protected:
+    std::basic_istream<C,T>* _in;
+    typename scan::set_t _set;
+    bool _unite;
+    bool _done;
+    string_t _field;
+
+    static typename scan::set_t make_set(const view_t& delim, int& null_unite)
+    {
+        const C* spc=delim.data();
+        size_t n=delim.size();
+        detail::split_args(spc, n, null_unite);
+        return typename scan::set_t(spc, n);
+    }
+
+    // read the next field into _field
+    bool next()
+    {
+        if(_done)
+            return false;
+        std::basic_streambuf<C,T>* sb=_in->rdbuf();
+        typename T::int_type c;
+        if(_unite){
+            while(1){
+                c=sb->sgetc();
+                if(T::eq_int_type(c, T::eof())){
+                    _done=true;
+                    _in->setstate(std::ios_base::eofbit);
+                    return false;
+                }
+                if(!_set.has(T::to_char_type(c)))
+                    break;
+                sb->sbumpc();
+            }
+        }
+        _field.clear();
+        while(1){
+            c=sb->sbumpc();
+            if(T::eq_int_type(c, T::eof())){
+                _done=true;
+                _in->setstate(std::ios_base::eofbit);
+                break;
+            }
+            C ch=T::to_char_type(c);
+            if(_set.has(ch))
+                break;
+            _field.push_back(ch);
+        }
+        return true;
+    }
+
+public:
+    /** a range of fields read from in.
+     * Up to 16 delimiters are copied, more are referred to.
+     */
+    stream_split_range_(std::basic_istream<C,T>& in, const view_t& delim=view_t(), int null_unite=-1):
+        _in(&in), _set(make_set(delim, null_unite)), _unite(null_unite), _done(!in.rdbuf())
+    {}
+
+    /** start reading; an input range is iterated only once.
+     */
+    iterator begin()
+    {
+        iterator it;
+        if(next())
+            it._r=this;
+        return it;
+    }
+
+    iterator end()
+    {
+        return iterator();
     }
 };
 
+/** split a string lazily, see basic_string_::isplit().
+ * The range refers to s, so s must outlive it.
+ */
+template<typename C, typename T, typename A>
+split_range_<C,T> isplit(const std::basic_string<C,T,A>& s,
+                         const typename split_range_<C,T>::view_t& delim=basic_string_view_<C,T>(), int null_unite=-1)
+{
+    return split_range_<C,T>(s, delim, null_unite);
+}
+
+template<typename C, typename T>
+split_range_<C,T> isplit(const basic_string_view_<C,T>& s,
+                         const typename split_range_<C,T>::view_t& delim=basic_string_view_<C,T>(), int null_unite=-1)
+{
+    return split_range_<C,T>(s, delim, null_unite);
+}
+
+/** split the text from a stream lazily, as split() does.
+ * Fields are read on demand, and reading stops where iterating stops.
+ * @param in           the input stream
+ * @param delim        the delimiters
+ * @param null_unite -1: a.c.t. python depent on token, 0: false, 1: true
+ * @return the input range of fields
+ */
+template<typename C, typename T>
+stream_split_range_<C,T> isplit(std::basic_istream<C,T>& in,
+                                const typename stream_split_range_<C,T>::view_t& delim=basic_string_view_<C,T>(), int null_unite=-1)
+{
+    return stream_split_range_<C,T>(in, delim, null_unite);
+}
+
 /**
  * @example string.cpp
  */
@@ -1076,15 +2240,17 @@ const basic_string_<T,C,A>&& cast_(const std::basic_string<T,C,A>&&  x)
 }
 
 /** read a line from stream.
- * @return the line. If empty it means there is no data in the stream; otherwise a delim is always put in the end.
+ * getline() hits eof only if the line has no delim, so no tellg() is needed,
+ * and pipes work too. For reading many lines, see line_reader in <proton/io.hpp>.
+ * @return the line. If empty it means there is no data in the stream; otherwise a delim is put in the end,
+ *         unless the stream ends without one.
  */
 template<typename C, typename T>
 std::basic_string<C,T, smart_allocator<C> > readline(std::basic_istream<C,T>& f, C delim=*detail::vals<C>::newline)
 {
     std::basic_string<C,T,smart_allocator<C> > r;
-    std::ios::pos_type start=f.tellg();
     std::getline(f, r, delim);
-    if(f.tellg()>start){
+    if(f.good()){
         r.push_back(delim);
     }
     return r;
@@ -1105,7 +2271,7 @@ public:
     typedef proton::basic_string_<T,C,A>      argument_type;
     size_t operator()(const proton::basic_string_<T,C,A> &s) const noexcept
     {
-        return std::hash<std::basic_string<T> >()(reinterpret_cast<const std::basic_string<T>&>(s));
+        return proton::hash_bytes(s.data(), s.size()*sizeof(T));
     }
 };
 
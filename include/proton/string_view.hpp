@@ -0,0 +1,250 @@
+#ifndef PROTON_STRING_VIEW_HEADER
+#define PROTON_STRING_VIEW_HEADER
+
+/** @file string_view.hpp
+ *  @brief read-only views of chars in strings, a C++11 counterpart of std::string_view.
+ */
+
+#include <iostream>
+#include <string>
+#include <algorithm>
+#include <stdexcept>
+#include <functional>
+#if __cplusplus >= 201703L
+#include <string_view>
+#endif
+#include <proton/base.hpp>
+#include <proton/hash.hpp>
+
+namespace proton{
+
+/** @addtogroup str
+ * @{
+ */
+
+/** a view of chars owned by someone else, like std::basic_string_view.
+ * It never copies the chars, so the owner must outlive the view.
+ * Under C++17 it converts from and to std::basic_string_view.
+ */
+template<typename CharT, typename Traits=std::char_traits<CharT> >
+class basic_string_view_ {
+public:
+    typedef CharT value_type;
+    typedef Traits traits_type;
+    typedef const CharT* const_iterator;
+    typedef const CharT* iterator;
+    typedef size_t size_type;
+    static constexpr size_t npos=size_t(-1);
+
+protected:
+    const CharT* _p;
+    size_t _n;
+
+public:
+    basic_string_view_():_p(NULL), _n(0)
+    {}
+
+    basic_string_view_(const CharT* s):_p(s), _n(Traits::length(s))
+    {}
+
+    basic_string_view_(const CharT* s, size_t n):_p(s), _n(n)
+    {}
+
+    /** the chars in [b,e).
+     */
+    basic_string_view_(const CharT* b, const CharT* e):_p(b), _n(e-b)
+    {}
+
+    /** a view of a whole string, including basic_string_.
+     */
+    template<typename A>
+    basic_string_view_(const std::basic_string<CharT,Traits,A>& s):_p(s.data()), _n(s.size())
+    {}
+
+#if __cplusplus >= 201703L
+    basic_string_view_(std::basic_string_view<CharT,Traits> s):_p(s.data()), _n(s.size())
+    {}
+
+    operator std::basic_string_view<CharT,Traits>()const
+    {
+        return std::basic_string_view<CharT,Traits>(_p, _n);
+    }
+#endif
+
+    /** copy the chars to a new string.
+     */
+    template<typename A>
+    operator std::basic_string<CharT,Traits,A>()const
+    {
+        return std::basic_string<CharT,Traits,A>(_p, _n);
+    }
+
+    const CharT* data()const
+    {
+        return _p;
+    }
+
+    size_t size()const
+    {
+        return _n;
+    }
+
+    size_t length()const
+    {
+        return _n;
+    }
+
+    bool empty()const
+    {
+        return _n==0;
+    }
+
+    const CharT* begin()const
+    {
+        return _p;
+    }
+
+    const CharT* end()const
+    {
+        return _p+_n;
+    }
+
+    const CharT& operator[](size_t i)const
+    {
+        return _p[i];
+    }
+
+    const CharT& front()const
+    {
+        return _p[0];
+    }
+
+    const CharT& back()const
+    {
+        return _p[_n-1];
+    }
+
+    void remove_prefix(size_t n)
+    {
+        _p+=n;
+        _n-=n;
+    }
+
+    void remove_suffix(size_t n)
+    {
+        _n-=n;
+    }
+
+    /** a view of [pos, pos+n) clamped to the end.
+     * @throw std::out_of_range if pos>size().
+     */
+    basic_string_view_ substr(size_t pos, size_t n=npos)const
+    {
+        if(pos>_n)
+            throw std::out_of_range("substr() of a string view");
+        return basic_string_view_(_p+pos, std::min(n, _n-pos));
+    }
+
+    /** the index of the first c from pos, or npos.
+     */
+    size_t find(CharT c, size_t pos=0)const
+    {
+        if(pos>=_n)
+            return npos;
+        const CharT* q=Traits::find(_p+pos, _n-pos, c);
+        return q ? q-_p : npos;
+    }
+
+    int compare(basic_string_view_ x)const
+    {
+        int r=Traits::compare(_p, x._p, std::min(_n, x._n));
+        if(r)
+            return r;
+        return _n<x._n ? -1 : (_n>x._n ? 1 : 0);
+    }
+
+    // as friends, strings and C strings compare with views by conversions
+    friend bool operator==(basic_string_view_ x, basic_string_view_ y)
+    {
+        return x._n==y._n && Traits::compare(x._p, y._p, x._n)==0;
+    }
+
+    friend bool operator!=(basic_string_view_ x, basic_string_view_ y)
+    {
+        return !(x==y);
+    }
+
+    friend bool operator<(basic_string_view_ x, basic_string_view_ y)
+    {
+        return x.compare(y)<0;
+    }
+
+    friend bool operator>(basic_string_view_ x, basic_string_view_ y)
+    {
+        return x.compare(y)>0;
+    }
+
+    friend bool operator<=(basic_string_view_ x, basic_string_view_ y)
+    {
+        return x.compare(y)<=0;
+    }
+
+    friend bool operator>=(basic_string_view_ x, basic_string_view_ y)
+    {
+        return x.compare(y)>=0;
+    }
+};
+
+template<typename C, typename T>
+constexpr size_t basic_string_view_<C,T>::npos;
+
+/** a view of str.
+ */
+typedef basic_string_view_<char> str_view;
+
+/** a view of wstr.
+ */
+typedef basic_string_view_<wchar_t> wstr_view;
+
+/** general output for string views, padded as strings are.
+ */
+template<typename C, typename T>
+std::basic_ostream<C,T>& operator<<(std::basic_ostream<C,T>& o, const basic_string_view_<C,T>& x)
+{
+    std::streamsize w=o.width();
+    std::streamsize pad=(w>(std::streamsize)x.size() ? w-x.size() : 0);
+    bool left=(o.flags() & std::ios_base::adjustfield)==std::ios_base::left;
+    if(!left)
+        for(std::streamsize i=0; i<pad; i++)
+            o.put(o.fill());
+    o.write(x.data(), x.size());
+    if(left)
+        for(std::streamsize i=0; i<pad; i++)
+            o.put(o.fill());
+    o.width(0);
+    return o;
+}
+
+/**
+ * @}
+ */
+
+} // ns proton
+
+namespace std{
+
+template<typename C, typename T>
+struct hash<proton::basic_string_view_<C,T> >{
+public:
+    typedef size_t     result_type;
+    typedef proton::basic_string_view_<C,T>      argument_type;
+    // the same value as the hash of a proton string with these chars
+    size_t operator()(const proton::basic_string_view_<C,T>& s) const noexcept
+    {
+        return proton::hash_bytes(s.data(), s.size()*sizeof(C));
+    }
+};
+
+} // ns std
+
+#endif // PROTON_STRING_VIEW_HEADER
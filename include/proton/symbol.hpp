@@ -0,0 +1,213 @@
+#ifndef PROTON_SYMBOL_HEADER
+#define PROTON_SYMBOL_HEADER
+
+/** @file symbol.hpp
+ *  @brief interned strings, compared by pointers.
+ */
+
+#include <atomic>
+#include <iostream>
+#include <string>
+#include <functional>
+#include <proton/base.hpp>
+#include <proton/pool.hpp>
+#include <proton/string_view.hpp>
+
+namespace proton{
+
+namespace detail{
+
+/** an interned string in the symbol table.
+ * Entries are allocated from per_pool and never freed.
+ */
+struct symbol_entry{
+    size_t hash;
+    size_t len;
+    std::atomic<symbol_entry*> next; ///< the next entry in the bucket
+    char chars[1];                   ///< len chars and a '\0'
+};
+
+/** find or add s in the symbol table.
+ * Lookups of existing entries are lock-free, adding takes the lock of a shard.
+ */
+const symbol_entry* intern(const char* s, size_t len, size_t hash);
+
+/** find s in the symbol table, or NULL.
+ */
+const symbol_entry* find_symbol(const char* s, size_t len, size_t hash);
+
+/** the entry of "", not in the table, with no hash.
+ */
+extern const symbol_entry empty_symbol;
+
+} // ns detail
+
+/** @addtogroup str
+ * @{
+ */
+
+/** an interned string.
+ * Equal strings get the same entry in a global table, so a symbol is a pointer:
+ * copying it allocates nothing, and == and hashing don't look at chars.
+ * Interned chars live till the end of the process, so use symbols for
+ * recurring names and keys, not for arbitrary data.
+ * < compares the chars, so ordered containers keep a stable order.
+ */
+class symbol{
+protected:
+    const detail::symbol_entry* _e;
+
+    explicit symbol(const detail::symbol_entry* e):_e(e)
+    {}
+
+public:
+    /** the empty symbol.
+     */
+    symbol():_e(&detail::empty_symbol)
+    {}
+
+    /** intern chars, from a view, str, std::string or C string.
+     */
+    explicit symbol(const str_view& s):
+        _e(s.empty() ? &detail::empty_symbol : detail::intern(s.data(), s.size(), std::hash<str_view>()(s)))
+    {}
+
+    /** the symbol of s if it has been interned, or the empty symbol.
+     * It never adds to the table.
+     * @param found set to whether s is interned
+     */
+    static symbol find(const str_view& s, bool& found)
+    {
+        if(s.empty()){
+            found=true;
+            return symbol();
+        }
+        const detail::symbol_entry* e=detail::find_symbol(s.data(), s.size(), std::hash<str_view>()(s));
+        found=(e!=NULL);
+        return e ? symbol(e) : symbol();
+    }
+
+    const char* data()const
+    {
+        return _e->chars;
+    }
+
+    const char* c_str()const
+    {
+        return _e->chars;
+    }
+
+    size_t size()const
+    {
+        return _e->len;
+    }
+
+    size_t length()const
+    {
+        return _e->len;
+    }
+
+    bool empty()const
+    {
+        return _e->len==0;
+    }
+
+    const char* begin()const
+    {
+        return _e->chars;
+    }
+
+    const char* end()const
+    {
+        return _e->chars+_e->len;
+    }
+
+    /** the hash, computed once when interned; the same as of a str with the chars.
+     */
+    size_t hash()const
+    {
+        return _e->len ? _e->hash : std::hash<str_view>()(str_view()); // empty_symbol is static
+    }
+
+    operator str_view()const
+    {
+        return str_view(_e->chars, _e->len);
+    }
+
+    /** a copy in a std::basic_string, including str.
+     */
+    template<typename A>
+    operator std::basic_string<char,std::char_traits<char>,A>()const
+    {
+        return std::basic_string<char,std::char_traits<char>,A>(_e->chars, _e->len);
+    }
+
+    bool operator==(const symbol& x)const
+    {
+        return _e==x._e;
+    }
+
+    bool operator!=(const symbol& x)const
+    {
+        return _e!=x._e;
+    }
+
+    bool operator<(const symbol& x)const
+    {
+        return _e!=x._e && str_view(*this)<str_view(x);
+    }
+
+    bool operator>(const symbol& x)const
+    {
+        return x<*this;
+    }
+
+    bool operator<=(const symbol& x)const
+    {
+        return !(x<*this);
+    }
+
+    bool operator>=(const symbol& x)const
+    {
+        return !(*this<x);
+    }
+};
+
+/** intern a string, like sys.intern() in python.
+ */
+inline symbol intern(const str_view& s)
+{
+    return symbol(s);
+}
+
+/** the number of interned strings.
+ */
+size_t symbol_count();
+
+inline std::ostream& operator<<(std::ostream& o, const symbol& x)
+{
+    return o << str_view(x);
+}
+
+/**
+ * @}
+ */
+
+} // ns proton
+
+namespace std{
+
+template<>
+struct hash<proton::symbol>{
+public:
+    typedef size_t     result_type;
+    typedef proton::symbol      argument_type;
+    size_t operator()(const proton::symbol& s) const noexcept
+    {
+        return s.hash();
+    }
+};
+
+} // ns std
+
+#endif // PROTON_SYMBOL_HEADER
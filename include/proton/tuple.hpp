@@ -16,6 +16,7 @@
 #include <limits>
 
 #include <proton/base.hpp>
+#include <proton/hash.hpp>
 
 namespace proton{
 
@@ -207,6 +208,24 @@ struct output_tuple<T, 0> {
     }
 };
 
+// helper function to hash the items of a tuple from the I-th one
+template<typename T, size_t I, size_t N=std::tuple_size<T>::value>
+struct hash_tuple {
+    static size_t hash(size_t seed, const T& t)
+    {
+        typedef typename std::decay<typename std::tuple_element<I,T>::type>::type item_t;
+        return hash_tuple<T, I+1, N>::hash(hash_combine(seed, proton::hasher<item_t>()(std::get<I>(t))), t);
+    }
+};
+
+template<typename T, size_t N>
+struct hash_tuple<T, N, N> {
+    static size_t hash(size_t seed, const T& t)
+    {
+        return seed;
+    }
+};
+
 } // ns detail
 
 /** get a slice of tuple x[begin:end] in python
@@ -277,6 +296,20 @@ auto _f(T&& ...x) -> decltype(std::forward_as_tuple(x...))
 	return std::forward_as_tuple(x...);
 }
 
+/** the items hashed by hasher and combined in order, so tuples can be keys
+ * of unordered_map_ and unordered_set_.
+ */
+template<typename ...T>
+struct hasher<std::tuple<T...> >{
+public:
+    typedef size_t     result_type;
+    typedef std::tuple<T...>      argument_type;
+    size_t operator()(const std::tuple<T...>& x) const
+    {
+        return detail::hash_tuple<std::tuple<T...>, 0>::hash(detail::hash_seed, x);
+    }
+};
+
 /**
  * @example tuple.cpp
  * @}
@@ -7,6 +7,7 @@
 #include <proton/base.hpp>
 #include <proton/pool.hpp>
 #include <proton/ref.hpp>
+#include <proton/hash.hpp>
 
 #include "_mapped_type.hpp"
 
@@ -68,7 +69,7 @@ std::wostream& operator<<(std::wostream& s, const std::unordered_map<_Key, _Tp,
 
 /** an unordered_map extension implementing python's dict-like interfaces.
  */
-template <typename K, typename T, typename H=std::hash<K>, typename E=std::equal_to<K>,
+template <typename K, typename T, typename H=proton::hasher<K>, typename E=std::equal_to<K>,
 		typename A=smart_allocator<std::pair<const K,T> > >
 class unordered_map_ : public std::unordered_map<K,T,H,E,A>{
 public:
@@ -93,13 +94,13 @@ public:
 
     /** move ctor.
      */
-    unordered_map_(unordered_map_&& x)noexcept:baseT(x)
+    unordered_map_(unordered_map_&& x)noexcept:baseT(std::move(x))
     {}
 
     explicit unordered_map_(const baseT& x):baseT(x)
     {}
 
-    unordered_map_(baseT&& x)noexcept:baseT(x)
+    unordered_map_(baseT&& x)noexcept:baseT(std::move(x))
     {}
 
     /** assign.
@@ -112,7 +113,7 @@ public:
 
     unordered_map_& operator=(unordered_map_&& x)noexcept
     {
-        baseT::operator=(x);
+        baseT::operator=(std::move(x));
         return *this;
     }
 
@@ -124,7 +125,7 @@ public:
 
     unordered_map_& operator=(baseT&& x)noexcept
     {
-        baseT::operator=(x);
+        baseT::operator=(std::move(x));
         return *this;
     }
 
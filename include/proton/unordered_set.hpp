@@ -8,6 +8,7 @@
 #include <proton/base.hpp>
 #include <proton/pool.hpp>
 #include <proton/ref.hpp>
+#include <proton/hash.hpp>
 
 namespace proton{
 
@@ -76,7 +77,7 @@ std::ostream& operator<<(std::ostream& s, const std::unordered_set<T,H,C,A>& x)
 
 /** an unordered_set extension implementing python's unordered_set-like interfaces.
  */
-template<typename T, typename H=std::hash<T>, typename E=std::equal_to<T>, typename A=smart_allocator<T> >
+template<typename T, typename H=proton::hasher<T>, typename E=std::equal_to<T>, typename A=smart_allocator<T> >
 class unordered_set_ : public std::unordered_set<T,H,E,A>{
 public:
     typedef std::unordered_set<T,H,E,A> baseT;
@@ -99,13 +100,13 @@ public:
 
     /** move ctor.
      */
-    unordered_set_(unordered_set_&& x)noexcept:baseT(x)
+    unordered_set_(unordered_set_&& x)noexcept:baseT(std::move(x))
     {}
 
     explicit unordered_set_(const baseT& x):baseT(x)
     {}
 
-    unordered_set_(baseT&& x)noexcept:baseT(x)
+    unordered_set_(baseT&& x)noexcept:baseT(std::move(x))
     {}
 
     /** assign.
@@ -118,7 +119,7 @@ public:
 
     unordered_set_& operator=(unordered_set_&& x)noexcept
     {
-        baseT::operator=(x);
+        baseT::operator=(std::move(x));
         return *this;
     }
 
@@ -130,7 +131,7 @@ public:
 
     unordered_set_& operator=(baseT&& x)noexcept
     {
-        baseT::operator=(x);
+        baseT::operator=(std::move(x));
         return *this;
     }
 
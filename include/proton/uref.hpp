@@ -0,0 +1,340 @@
+#ifndef PROTON_UREF_HEADER
+#define PROTON_UREF_HEADER
+
+/** @file uref.hpp
+ *  @brief a move-only ref without reference counting.
+ */
+
+#include <iostream>
+#include <typeinfo>
+#include <type_traits>
+#include <utility>
+#include <proton/base.hpp>
+#include <proton/pool.hpp>
+#include <proton/ref.hpp>
+
+namespace proton{
+
+/** @addtogroup ref_
+ * @{
+ */
+
+/** A single owner ref, like std::unique_ptr for ref_.
+ * It is move-only and holds only a pointer to the object, and it never counts,
+ * so moving and destroying it need no refc_t access.
+ * The object is allocated in the same chunk layout as ref_, with the refc_t word
+ * left unconstructed, so a uref_ converts into a ref_ in place:
+ *     ref_<T> r=std::move(u);
+ * @param objT the object type
+ * @param allocator the allocator of chunks, as in ref_
+ * @param traits the traits, as in ref_
+ * @param refcT the refc_t of ref_ it converts into
+ */
+template<typename objT, typename allocator=smart_allocator<objT>,
+		typename traits=ref_traits<objT>, typename refcT=detail::refc_t >
+class uref_ {
+template<typename O, typename A, typename T, typename R>
+    friend class uref_;
+template<typename O, typename A, typename T, typename R>
+	friend struct ref_;
+template<typename C, typename O, typename A, typename T, typename R>
+    friend C cast(uref_<O,A,T,R>&& x);
+
+public:
+    typedef uref_ proton_uref_self_t;
+    typedef objT obj_t;
+    typedef allocator alloc_t;
+    typedef traits traits_t;
+    typedef refcT refc_t;
+
+protected:
+    objT* _p;
+
+    // the same layout as ref_obj_t in ref_, with an unconstructed refc_t
+    struct uref_obj_t{
+        typename std::aligned_storage<sizeof(refc_t), alignof(refc_t)>::type r;
+        obj_t o;
+    };
+    typedef typename alloc_t::template rebind<uref_obj_t>::other real_alloc;
+
+    // the offset of the object in its chunk
+    static constexpr size_t obj_offset=
+        (sizeof(refc_t)+alignof(objT)-1)/alignof(objT)*alignof(objT);
+
+    static void* chunk(objT* p)
+    {
+        return (char*)p-obj_offset;
+    }
+
+    void release()
+    {
+        if(_p){
+            objT* p=_p;
+            _p=NULL;
+            p->~objT();
+            alloc_t::confiscate(chunk(p));
+        }
+    }
+
+private:
+    uref_(const uref_&); ///< disabled
+    uref_& operator=(const uref_&); ///< disabled
+
+public:
+    /** default ctor.
+     * Doesn't own any object.
+     */
+    uref_():_p(NULL)
+    {}
+
+    uref_(init_alloc_none):_p(NULL)
+    {}
+
+    /** forwarding ctor.
+     * Construct an obj_t using given args.
+     */
+    template<typename ...argT> explicit uref_(init_alloc, argT&& ...a)
+    {
+        void* p=real_alloc::allocate(1);
+        if(!p)
+            throw std::bad_alloc();
+        try{
+            _p=new ((char*)p+obj_offset) objT(std::forward<argT>(a)...);
+        }
+        catch(...){
+            alloc_t::confiscate(p);
+            throw;
+        }
+    }
+
+    /** initializer_list forwarding ctor.
+     */
+    template<typename T> uref_(init_alloc, std::initializer_list<T> a):uref_(alloc, a, 0)
+    {}
+
+private:
+    template<typename T> uref_(init_alloc, std::initializer_list<T> a, int)
+    {
+        void* p=real_alloc::allocate(1);
+        if(!p)
+            throw std::bad_alloc();
+        try{
+            _p=new ((char*)p+obj_offset) objT(a);
+        }
+        catch(...){
+            alloc_t::confiscate(p);
+            throw;
+        }
+    }
+
+public:
+    /** move ctor.
+     */
+    uref_(uref_&& x)noexcept:_p(x._p)
+    {
+        x._p=NULL;
+    }
+
+    /** move from a uref_ of a derived class.
+     * Only for first bases, as the chunk is found by the object address.
+     */
+    template<typename O, typename A, typename T, typename=typename std::enable_if<
+            std::is_base_of<objT, O>::value && !std::is_same<objT, O>::value
+            && std::is_same<typename A::template rebind<objT>::other, allocator>::value
+        >::type>
+    uref_(uref_<O,A,T,refcT>&& x):_p(static_cast<objT*>(x._p))
+    {
+        static_assert(uref_<O,A,T,refcT>::obj_offset==obj_offset, "can not convert to a base with a different alignment");
+        PROTON_THROW_IF((void*)_p!=(void*)x._p, "can not convert to a non-first-base uref_");
+        x._p=NULL;
+    }
+
+    uref_& operator=(uref_&& x)noexcept(noexcept(_p->~objT()))
+    {
+        if(this!=&x){
+            release();
+            _p=x._p;
+            x._p=NULL;
+        }
+        return *this;
+    }
+
+    uref_& operator=(init_alloc_none)noexcept(noexcept(_p->~objT()))
+    {
+        release();
+        return *this;
+    }
+
+    ~uref_()noexcept(noexcept(_p->~objT()))
+    {
+        release();
+    }
+
+    void swap(uref_& x)noexcept
+    {
+        std::swap(_p, x._p);
+    }
+
+    const objT& __o()const
+    {
+        return *_p;
+    }
+
+    objT& __o()
+    {
+        return *_p;
+    }
+
+    objT& operator *()
+    {
+        return *_p;
+    }
+
+    const objT& operator *()const
+    {
+        return *_p;
+    }
+
+    objT* operator->()
+    {
+        return _p;
+    }
+
+    const objT* operator->()const
+    {
+        return _p;
+    }
+
+    bool operator==(const init_alloc_none&)const
+    {
+        return _p==NULL;
+    }
+
+    bool operator!=(const init_alloc_none&)const
+    {
+        return _p!=NULL;
+    }
+
+    /** compare objects, like ref_.
+     */
+    template<typename T>
+    typename std::enable_if<std::is_class<typename T::proton_uref_self_t>::value, bool>::type
+        operator==(const T& x)const
+    {
+        if((void*)_p==(void*)x._p)
+            return true;
+        if(_p==NULL || x._p==NULL)
+            return false;
+        return *_p == *x._p;
+    }
+
+    template<typename T>
+    typename std::enable_if<std::is_class<typename T::proton_uref_self_t>::value, bool>::type
+        operator!=(const T& x)const
+    {
+        return !(*this==x);
+    }
+
+    template<typename T>
+    typename std::enable_if<std::is_class<typename T::proton_uref_self_t>::value, bool>::type
+        operator<(const T& x)const
+    {
+        if(x._p==NULL)
+            return false;
+        if(_p==NULL)
+            return true;
+        return *_p < *x._p;
+    }
+
+    template<typename ...T> auto operator()(T&& ...x)const -> decltype(std::declval<const objT&>()(x...))
+    {
+        PROTON_THROW_IF(_p==NULL, "nullptr for ()");
+        return (*_p)(x...);
+    }
+
+    template<typename ...T> auto operator()(T&& ...x) -> decltype((*_p)(x...))
+    {
+        PROTON_THROW_IF(_p==NULL, "nullptr for ()");
+        return (*_p)(x...);
+    }
+
+    template<typename T> auto operator[](T&& x)const -> decltype(std::declval<const objT&>()[x])
+    {
+        PROTON_THROW_IF(_p==NULL, "nullptr for []");
+        return (*_p)[x];
+    }
+
+    template<typename T> auto operator[](T&& x) -> decltype((*_p)[x])
+    {
+        PROTON_THROW_IF(_p==NULL, "nullptr for []");
+        return (*_p)[x];
+    }
+};
+
+/** construct an object owned by a uref_.
+ * Args are perfectly forwarded to the ctor of the object.
+ * @param T the object type
+ * @return the new uref_
+ */
+template<typename T, typename ...argT>
+uref_<T> make_uref(argT&& ...a)
+{
+    return uref_<T>(alloc, std::forward<argT>(a)...);
+}
+
+/** cast a uref_ to another, moving the object on success.
+ * If casting fails, throw std::bad_cast(), and x still owns the object.
+ * Type tags are used as cast<>() of ref_ does, see PROTON_TYPE_ROOT().
+ * @param x the original uref_
+ * @return the casted one
+ */
+template<typename C, typename O, typename A, typename T, typename R>
+C cast(uref_<O,A,T,R>&& x)
+{
+    if(x==none)
+        return C();
+    typedef typename C::obj_t target_t;
+    static_assert(C::obj_offset==uref_<O,A,T,R>::obj_offset, "can not cast to a class with a different alignment");
+    target_t* p=detail::fast_cast<target_t>(x._p);
+    if(!p)
+        throw std::bad_cast();
+    PROTON_THROW_IF((void*)p!=(void*)x._p, "can not cast to a non-first-base uref_");
+    C r;
+    r._p=p;
+    x._p=NULL;
+    return r;
+}
+
+/** general output for urefs, like ref_.
+ */
+template<typename O, typename A, typename T, typename R>
+typename std::enable_if<!(T::flag & ref_not_use_output), std::ostream&>::type
+operator<<(std::ostream& s, const uref_<O,A,T,R>& y)
+{
+    if(y==none){
+        s << "<>" ;
+        return s;
+    }
+    y->output(s);
+    return s;
+}
+
+template<typename O, typename A, typename T, typename R>
+typename std::enable_if<T::flag & ref_not_use_output, std::ostream&>::type
+operator<<(std::ostream& s, const uref_<O,A,T,R>& y)
+{
+    if(y==none){
+        s << "<>" ;
+        return s;
+    }
+    s << y.__o();
+    return s;
+}
+
+/**
+ * @}
+ */
+
+} // ns proton
+
+#endif // PROTON_UREF_HEADER
@@ -17,6 +17,8 @@
 #include <proton/base.hpp>
 #include <proton/pool.hpp>
 #include <proton/ref.hpp>
+#include <proton/hash.hpp>
+#include <proton/slice.hpp>
 
 namespace proton{
 
@@ -250,13 +252,13 @@ public:
 
     /** move ctor.
      */
-    vector_(vector_&& x)noexcept:baseT(x)
+    vector_(vector_&& x)noexcept:baseT(std::move(x))
     {}
 
     explicit vector_(const baseT& x):baseT(x)
     {}
 
-    vector_(baseT&& x)noexcept:baseT(x)
+    vector_(baseT&& x)noexcept:baseT(std::move(x))
     {}
 
     /** assign.
@@ -269,7 +271,7 @@ public:
 
     vector_& operator=(vector_&& x)noexcept
     {
-        baseT::operator=(x);
+        baseT::operator=(std::move(x));
         return *this;
     }
 
@@ -281,7 +283,7 @@ public:
 
     vector_& operator=(baseT&& x)noexcept
     {
-        baseT::operator=(x);
+        baseT::operator=(std::move(x));
         return *this;
     }
 
@@ -348,6 +350,40 @@ public:
         return r;
     }
 
+    /** a view of [i:], like operator()(i) without copying items.
+     * It throws on an offset out of range, as operator()(i) does.
+     */
+    slice_<typename baseT::const_iterator> view(offset_t i)const
+    {
+        i=offset(i);
+        return slice_<typename baseT::const_iterator>(this->begin()+i, this->size()-i);
+    }
+
+    /** a view of [i:j:k], like operator()(i,j,k) without copying items.
+     * Offsets are fixed the same way. The view is invalidated as iterators are.
+     */
+    slice_<typename baseT::const_iterator> view(offset_t i, offset_t j, size_t k=1)const
+    {
+        fix_range(i,j);
+        return slice_<typename baseT::const_iterator>::of(this->begin()+i, this->begin()+j, k);
+    }
+
+    /** a writable view of [i:], throws on an offset out of range.
+     */
+    slice_<typename baseT::iterator> view(offset_t i)
+    {
+        i=offset(i);
+        return slice_<typename baseT::iterator>(this->begin()+i, this->size()-i);
+    }
+
+    /** a writable view of [i:j:k], items can be assigned through it.
+     */
+    slice_<typename baseT::iterator> view(offset_t i, offset_t j, size_t k=1)
+    {
+        fix_range(i,j);
+        return slice_<typename baseT::iterator>::of(this->begin()+i, this->begin()+j, k);
+    }
+
     /** append an item at the end.
      */
     void append(const T& x)
@@ -553,9 +589,41 @@ const vector_<T,A>&& cast_(const std::vector<T,A>&& x)
     return reinterpret_cast<const vector_<T,A>&&>(x);
 }
 
+namespace detail{
+
+template<typename T, typename A>
+size_t hash_vector(const std::vector<T,A>& x)
+{
+    return hash_items(x.data(), x.size(), hash_combine(hash_seed, x.size()));
+}
+
+// vector<bool> has no data()
+template<typename A>
+size_t hash_vector(const std::vector<bool,A>& x)
+{
+    return hash_range(x.begin(), x.end(), hash_combine(hash_seed, x.size()));
+}
+
+} // ns detail
+
 /**
  * @}
  */
 }
 
+namespace std{
+
+template<typename T, typename A>
+struct hash<proton::vector_<T,A> >{
+public:
+    typedef size_t     result_type;
+    typedef proton::vector_<T,A>      argument_type;
+    size_t operator()(const proton::vector_<T,A>& x) const
+    {
+        return proton::detail::hash_vector(x);
+    }
+};
+
+} // ns std
+
 #endif // PROTON_VECTOR_HEADER
@@ -0,0 +1,128 @@
+#include <deque>
+#include <vector>
+#include <proton/base.hpp>
+#include <proton/cycle.hpp>
+
+namespace proton{
+
+namespace detail{
+
+static std::deque<crefc_t*> cycle_roots_buf;
+
+void crefc_t::buffer_root(crefc_t* rc)
+{
+    cycle_roots_buf.push_back(rc);
+}
+
+} // ns detail
+
+using namespace detail;
+
+namespace {
+
+// push the children of an object to a stack
+class push_visitor:public cc_visitor{
+public:
+    std::vector<crefc_t*>& s;
+
+    push_visitor(std::vector<crefc_t*>& stack):s(stack)
+    {}
+
+protected:
+    void visit(crefc_t* rc)
+    {
+        s.push_back(rc);
+    }
+};
+
+} // ns
+
+// crefc_t is a friend of this function only, so the phases live here.
+size_t collect_cycles(size_t budget/*=size_t(-1)*/)
+{
+    std::vector<crefc_t*> g;     // gray nodes, in scan order
+    std::vector<crefc_t*> s;     // dfs stack
+    push_visitor pv(s);
+
+    // mark gray: take roots and walk the graphs reachable from them
+    while(!cycle_roots_buf.empty() && g.size()<budget){
+        crefc_t* rc=cycle_roots_buf.front();
+        cycle_roots_buf.pop_front();
+        rc->__buffered=false;
+        if(!rc->__obj){ // destroyed while buffered
+            rc->__free(rc);
+            continue;
+        }
+        if(rc->__color!=crefc_t::black)
+            continue;
+        s.push_back(rc);
+        while(!s.empty()){
+            crefc_t* p=s.back();
+            s.pop_back();
+            if(p->__color!=crefc_t::black)
+                continue;
+            p->__color=crefc_t::gray;
+            p->__trial=p->__r;
+            g.push_back(p);
+            p->__trace(p->__obj, pv);
+        }
+    }
+
+    // trial deletion: drop the counts from the inside of the scanned graphs
+    for(crefc_t* p: g){
+        p->__trace(p->__obj, pv);
+        for(crefc_t* c: s){
+            if(c->__color==crefc_t::gray)
+                c->__trial--;
+        }
+        s.clear();
+    }
+
+    // scan black: objects still referred from outside, and all reachable from them, are alive
+    for(crefc_t* p: g){
+        if(p->__color!=crefc_t::gray || p->__trial<=0)
+            continue;
+        s.push_back(p);
+        while(!s.empty()){
+            crefc_t* q=s.back();
+            s.pop_back();
+            if(q->__color!=crefc_t::gray)
+                continue;
+            q->__color=crefc_t::black;
+            q->__trace(q->__obj, pv);
+        }
+    }
+
+    // the rest are garbage
+    size_t n=0;
+    for(crefc_t* p: g){
+        if(p->__color==crefc_t::gray){
+            p->__color=crefc_t::white;
+            g[n++]=p;
+        }
+        else
+            p->__color=crefc_t::black;
+    }
+    g.resize(n);
+
+    // refs released by white objects don't touch other white ones
+    for(crefc_t* p: g){
+        void* obj=p->__obj;
+        p->__obj=NULL;
+        p->__destruct(obj);
+    }
+    for(crefc_t* p: g){
+        if(p->__buffered) // freed when popped from roots
+            p->__color=crefc_t::black;
+        else
+            p->__free(p);
+    }
+    return n;
+}
+
+size_t cycle_roots()
+{
+    return cycle_roots_buf.size();
+}
+
+} // ns proton
@@ -0,0 +1,116 @@
+#include <chrono>
+#include <proton/base.hpp>
+#include <proton/deferred.hpp>
+
+namespace proton{
+
+namespace detail{
+
+// objects any thread can destroy
+static std::atomic<retired_t*> retired_head(NULL);
+static std::atomic<size_t> retired_cnt(0);
+
+// objects only the thread retiring them can destroy
+static thread_local retired_t* local_head=NULL;
+static thread_local size_t local_cnt=0;
+
+// push a chain of retired objects from first to last to the global list
+static void push_chain(retired_t* first, retired_t* last)
+{
+    retired_t* head=retired_head.load(std::memory_order_relaxed);
+    do{
+        last->next=head;
+    }
+    while(!retired_head.compare_exchange_weak(head, first, std::memory_order_release,
+                                              std::memory_order_relaxed));
+}
+
+void retire(retired_t* r, bool shared)
+{
+    if(shared){
+        retired_cnt.fetch_add(1, std::memory_order_relaxed);
+        push_chain(r, r);
+    }
+    else{
+        local_cnt++;
+        r->next=local_head;
+        local_head=r;
+    }
+}
+
+} // ns detail
+
+using namespace detail;
+
+size_t collect(size_t max/*=size_t(-1)*/)
+{
+    size_t n=0;
+    while(n<max){
+        // the list of this thread first, then the global one
+        bool shared=(local_head==NULL);
+        retired_t* p;
+        if(shared){
+            p=retired_head.exchange(NULL, std::memory_order_acquire);
+            if(!p)
+                break;
+        }
+        else{
+            p=local_head;
+            local_head=NULL;
+        }
+        while(p && n<max){
+            retired_t* next=p->next; // p is freed by destroy()
+            if(shared)
+                retired_cnt.fetch_sub(1, std::memory_order_relaxed);
+            else
+                local_cnt--;
+            p->destroy(p->rc, p->obj);
+            n++;
+            p=next;
+        }
+        if(p){
+            // out of budget, put the rest back
+            retired_t* last=p;
+            while(last->next)
+                last=last->next;
+            if(shared)
+                push_chain(p, last);
+            else{
+                last->next=local_head;
+                local_head=p;
+            }
+        }
+    }
+    return n;
+}
+
+size_t retired_count()
+{
+    return retired_cnt.load(std::memory_order_relaxed)+local_cnt;
+}
+
+reclaimer::reclaimer(long interval_ms/*=10*/):_stop(false)
+{
+    _t=std::thread([this, interval_ms](){
+        std::unique_lock<std::mutex> lk(_m);
+        while(!_stop){
+            lk.unlock();
+            collect();
+            lk.lock();
+            _cv.wait_for(lk, std::chrono::milliseconds(interval_ms));
+        }
+    });
+}
+
+reclaimer::~reclaimer()
+{
+    {
+        std::lock_guard<std::mutex> lk(_m);
+        _stop=true;
+    }
+    _cv.notify_all();
+    _t.join();
+    collect();
+}
+
+} // ns proton
@@ -0,0 +1,230 @@
+#include <cerrno>
+#include <cstring>
+#include <system_error>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <proton/base.hpp>
+#include <proton/io.hpp>
+
+namespace proton{
+
+namespace {
+
+int open_file(const char* path)
+{
+    int fd;
+    do{
+        fd=::open(path, O_RDONLY);
+    }while(fd<0 && errno==EINTR);
+    if(fd<0)
+        throw std::system_error(errno, std::generic_category(), path);
+    return fd;
+}
+
+// write() retried on signals and partial writes
+void write_all(int fd, const char* p, size_t n)
+{
+    while(n){
+        ssize_t r=::write(fd, p, n);
+        if(r<0){
+            if(errno==EINTR)
+                continue;
+            throw std::system_error(errno, std::generic_category(), "write");
+        }
+        p+=r;
+        n-=r;
+    }
+}
+
+// read() retried on signals
+size_t read_some(int fd, char* p, size_t n, const char* name)
+{
+    ssize_t r;
+    do{
+        r=::read(fd, p, n);
+    }while(r<0 && errno==EINTR);
+    if(r<0)
+        throw std::system_error(errno, std::generic_category(), name);
+    return (size_t)r;
+}
+
+} // ns
+
+constexpr size_t line_reader::default_buf_size;
+
+line_reader::line_reader(int fd, char delim, size_t buf_size):
+    _fd(fd), _own(false), _sb(NULL), _delim(delim)
+{
+    init(buf_size);
+}
+
+line_reader::line_reader(const char* path, char delim, size_t buf_size):
+    _fd(open_file(path)), _own(true), _sb(NULL), _delim(delim)
+{
+    init(buf_size);
+}
+
+line_reader::line_reader(std::istream& f, char delim, size_t buf_size):
+    _fd(-1), _own(false), _sb(f.rdbuf()), _delim(delim)
+{
+    init(buf_size);
+}
+
+line_reader::~line_reader()
+{
+    if(_own)
+        ::close(_fd);
+}
+
+void line_reader::init(size_t buf_size)
+{
+    _cap=std::max(buf_size, (size_t)16);
+    _buf.reset(new char[_cap]);
+    _p=_e=_buf.get();
+    _offset=0;
+}
+
+bool line_reader::fill()
+{
+    char* b=_buf.get();
+    size_t n=_e-_p;
+    if(n==_cap){
+        // a line longer than the buffer
+        std::unique_ptr<char[]> x(new char[_cap*2]);
+        std::memcpy(x.get(), _p, n);
+        _buf.swap(x);
+        _cap*=2;
+        b=_buf.get();
+    }
+    else if(_p!=b)
+        std::memmove(b, _p, n);
+    _p=b;
+    _e=b+n;
+
+    size_t k;
+    if(_sb)
+        k=(size_t)_sb->sgetn(b+n, _cap-n);
+    else
+        k=read_some(_fd, b+n, _cap-n, "read");
+    _e+=k;
+    return k>0;
+}
+
+mapped_file::mapped_file(const char* path):_p(NULL), _n(0), _mapped(false), _skip(0)
+{
+    int fd=open_file(path);
+    try{
+        load(fd, path);
+    }
+    catch(...){
+        ::close(fd);
+        throw;
+    }
+    ::close(fd);
+}
+
+mapped_file::mapped_file(int fd):_p(NULL), _n(0), _mapped(false), _skip(0)
+{
+    load(fd, "read");
+}
+
+void mapped_file::load(int fd, const char* name)
+{
+    struct stat st;
+    off_t pos;
+    // files of size 0 may still have contents, like those in /proc
+    if(::fstat(fd, &st)==0 && S_ISREG(st.st_mode) && st.st_size>0 && (pos=::lseek(fd, 0, SEEK_CUR))>=0){
+        if(pos>=st.st_size)
+            return;
+        // map from the page holding the current position, where read() would start
+        off_t begin=pos-pos%(off_t)::sysconf(_SC_PAGESIZE);
+        size_t len=(size_t)(st.st_size-begin);
+        void* p=::mmap(NULL, len, PROT_READ, MAP_PRIVATE, fd, begin);
+        if(p!=MAP_FAILED){
+            ::madvise(p, len, MADV_SEQUENTIAL);
+            ::lseek(fd, st.st_size, SEEK_SET);
+            _skip=(size_t)(pos-begin);
+            _p=(const char*)p+_skip;
+            _n=len-_skip;
+            _mapped=true;
+            return;
+        }
+    }
+
+    size_t cap=64*1024;
+    std::unique_ptr<char[]> buf(new char[cap]);
+    size_t n=0;
+    while(1){
+        if(n==cap){
+            std::unique_ptr<char[]> x(new char[cap*2]);
+            std::memcpy(x.get(), buf.get(), n);
+            buf.swap(x);
+            cap*=2;
+        }
+        size_t k=read_some(fd, buf.get()+n, cap-n, name);
+        if(k==0)
+            break;
+        n+=k;
+    }
+    _buf.swap(buf);
+    _p=_buf.get();
+    _n=n;
+}
+
+void mapped_file::release()
+{
+    if(_mapped)
+        ::munmap((void*)(_p-_skip), _n+_skip);
+    _buf.reset();
+    _p=NULL;
+    _n=0;
+    _mapped=false;
+    _skip=0;
+}
+
+constexpr size_t out_buffer::default_buf_size;
+
+out_buffer::out_buffer(int fd, size_t buf_size):_fd(fd), _os(NULL)
+{
+    init(buf_size);
+}
+
+out_buffer::out_buffer(std::ostream& o, size_t buf_size):_fd(-1), _os(&o)
+{
+    init(buf_size);
+}
+
+out_buffer::~out_buffer()
+{
+    try{
+        flush();
+    }
+    catch(...){
+    }
+}
+
+void out_buffer::init(size_t buf_size)
+{
+    _cap=std::max(buf_size, (size_t)64);
+    _buf.reset(new char[_cap]);
+    _n=0;
+}
+
+void out_buffer::drain(const char* p, size_t n)
+{
+    if(_os)
+        _os->write(p, n);
+    else
+        write_all(_fd, p, n);
+}
+
+void out_buffer::flush()
+{
+    flush_buffer();
+    if(_os)
+        _os->flush();
+}
+
+} // ns proton
@@ -48,6 +48,11 @@ void* __mmdup(void* p)
     return mmalloc(s-sizeof(mmheader));
 }
 
+size_t mmsize(void* p)
+{
+    return (((mmheader*)p)-1)->len-sizeof(mmheader);
+}
+
 void mmfree(void* p)
 {
     mmheader* r=((mmheader*)p)-1;
@@ -0,0 +1,538 @@
+#include <atomic>
+#include <proton/detail/scan.hpp>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define PROTON_SCAN_X86 1
+#include <immintrin.h>
+#endif
+
+namespace proton{
+
+namespace detail{
+
+namespace {
+
+// sets of up to small_set chars are matched by compare-or, others by pcmpestri or the bitmap
+const unsigned small_set=8;
+
+/////////////////////////////////////////////
+// scalar
+
+const char* first_of_scalar(const char* b, const char* e, const char_set& s)
+{
+    for(; b<e; ++b)
+        if(s.has(*b))
+            return b;
+    return e;
+}
+
+const char* first_not_of_scalar(const char* b, const char* e, const char_set& s)
+{
+    for(; b<e; ++b)
+        if(!s.has(*b))
+            return b;
+    return e;
+}
+
+const char* last_not_of_scalar(const char* b, const char* e, const char_set& s)
+{
+    while(e>b){
+        --e;
+        if(!s.has(*e))
+            return e;
+    }
+    return NULL;
+}
+
+size_t count_scalar(const char* b, const char* e, char c)
+{
+    size_t n=0;
+    for(; b<e; ++b)
+        n+=(*b==c);
+    return n;
+}
+
+size_t count_tokens_scalar(const char* b, const char* e, const char_set& s, bool after_delim)
+{
+    size_t n=0;
+    for(; b<e; ++b){
+        bool d=s.has(*b);
+        n+=(after_delim && !d);
+        after_delim=d;
+    }
+    return n;
+}
+
+inline char ascii_case(char c, bool upper)
+{
+    if(upper)
+        return (c>='a' && c<='z') ? c-0x20 : c;
+    return (c>='A' && c<='Z') ? c+0x20 : c;
+}
+
+inline char ascii_lower(char c)
+{
+    return (c>='A' && c<='Z') ? c+0x20 : c;
+}
+
+const char* ascii_case_scalar(char* d, const char* b, const char* e, bool upper)
+{
+    for(; b<e && !(*b & 0x80); ++b, ++d)
+        *d=ascii_case(*b, upper);
+    return b;
+}
+
+const char* ascii_imismatch_scalar(const char* a, const char* e, const char* b)
+{
+    for(; a<e && !((*a | *b) & 0x80) && ascii_lower(*a)==ascii_lower(*b); ++a, ++b)
+        ;
+    return a;
+}
+
+#ifdef PROTON_SCAN_X86
+
+/////////////////////////////////////////////
+// sse2
+
+__attribute__((target("sse2")))
+inline unsigned match16(__m128i x, const __m128i* v, unsigned n)
+{
+    __m128i m=_mm_cmpeq_epi8(x, v[0]);
+    for(unsigned i=1; i<n; i++)
+        m=_mm_or_si128(m, _mm_cmpeq_epi8(x, v[i]));
+    return (unsigned)_mm_movemask_epi8(m);
+}
+
+__attribute__((target("sse2")))
+const char* first_of_sse2(const char* b, const char* e, const char_set& s)
+{
+    if(s.n>small_set || s.n==0)
+        return first_of_scalar(b, e, s);
+    __m128i v[small_set];
+    for(unsigned i=0; i<s.n; i++)
+        v[i]=_mm_set1_epi8((char)s.chars[i]);
+    for(; e-b>=16; b+=16){
+        unsigned m=match16(_mm_loadu_si128((const __m128i*)b), v, s.n);
+        if(m)
+            return b+__builtin_ctz(m);
+    }
+    return first_of_scalar(b, e, s);
+}
+
+__attribute__((target("sse2")))
+const char* first_not_of_sse2(const char* b, const char* e, const char_set& s)
+{
+    if(s.n>small_set || s.n==0)
+        return first_not_of_scalar(b, e, s);
+    __m128i v[small_set];
+    for(unsigned i=0; i<s.n; i++)
+        v[i]=_mm_set1_epi8((char)s.chars[i]);
+    for(; e-b>=16; b+=16){
+        unsigned m=~match16(_mm_loadu_si128((const __m128i*)b), v, s.n) & 0xffff;
+        if(m)
+            return b+__builtin_ctz(m);
+    }
+    return first_not_of_scalar(b, e, s);
+}
+
+__attribute__((target("sse2")))
+const char* last_not_of_sse2(const char* b, const char* e, const char_set& s)
+{
+    if(s.n>small_set || s.n==0)
+        return last_not_of_scalar(b, e, s);
+    __m128i v[small_set];
+    for(unsigned i=0; i<s.n; i++)
+        v[i]=_mm_set1_epi8((char)s.chars[i]);
+    for(; e-b>=16; e-=16){
+        unsigned m=~match16(_mm_loadu_si128((const __m128i*)(e-16)), v, s.n) & 0xffff;
+        if(m)
+            return e-16+(31-__builtin_clz(m));
+    }
+    return last_not_of_scalar(b, e, s);
+}
+
+__attribute__((target("sse2")))
+size_t count_sse2(const char* b, const char* e, char c)
+{
+    size_t n=0;
+    __m128i v=_mm_set1_epi8(c), zero=_mm_setzero_si128();
+    while(e-b>=16){
+        // up to 255 rounds in 8-bit counters
+        __m128i acc=_mm_setzero_si128();
+        size_t k=(size_t)(e-b)/16;
+        if(k>255)
+            k=255;
+        for(size_t i=0; i<k; i++, b+=16)
+            acc=_mm_sub_epi8(acc, _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)b), v));
+        __m128i sum=_mm_sad_epu8(acc, zero);
+        n+=(size_t)_mm_cvtsi128_si32(sum)+(size_t)_mm_extract_epi16(sum, 4);
+    }
+    return n+count_scalar(b, e, c);
+}
+
+// a token starts at a non-delimiter right after a delimiter, the bit of the last
+// char of a block carries to the next one
+__attribute__((target("sse2")))
+size_t count_tokens_sse2(const char* b, const char* e, const char_set& s, bool after_delim)
+{
+    if(s.n>small_set || s.n==0)
+        return count_tokens_scalar(b, e, s, after_delim);
+    __m128i v[small_set];
+    for(unsigned i=0; i<s.n; i++)
+        v[i]=_mm_set1_epi8((char)s.chars[i]);
+    size_t n=0;
+    unsigned carry=after_delim;
+    for(; e-b>=16; b+=16){
+        unsigned m=match16(_mm_loadu_si128((const __m128i*)b), v, s.n);
+        n+=__builtin_popcount(~m & ((m<<1) | carry) & 0xffff);
+        carry=m>>15;
+    }
+    return n+count_tokens_scalar(b, e, s, carry);
+}
+
+// the letters of x in ASCII, [lo,hi] is 'A'-'Z' or 'a'-'z'; signed compares skip non-ASCII chars
+__attribute__((target("sse2")))
+inline __m128i letters16(__m128i x, __m128i lo, __m128i hi)
+{
+    return _mm_andnot_si128(_mm_or_si128(_mm_cmplt_epi8(x, lo), _mm_cmpgt_epi8(x, hi)), _mm_set1_epi8(0x20));
+}
+
+__attribute__((target("sse2")))
+const char* ascii_case_sse2(char* d, const char* b, const char* e, bool upper)
+{
+    __m128i lo=_mm_set1_epi8(upper ? 'a' : 'A'), hi=_mm_set1_epi8(upper ? 'z' : 'Z');
+    for(; e-b>=16; b+=16, d+=16){
+        __m128i x=_mm_loadu_si128((const __m128i*)b);
+        if(_mm_movemask_epi8(x))
+            break;
+        _mm_storeu_si128((__m128i*)d, _mm_xor_si128(x, letters16(x, lo, hi)));
+    }
+    return ascii_case_scalar(d, b, e, upper);
+}
+
+__attribute__((target("sse2")))
+const char* ascii_imismatch_sse2(const char* a, const char* e, const char* b)
+{
+    __m128i lo=_mm_set1_epi8('A'), hi=_mm_set1_epi8('Z');
+    for(; e-a>=16; a+=16, b+=16){
+        __m128i x=_mm_loadu_si128((const __m128i*)a), y=_mm_loadu_si128((const __m128i*)b);
+        x=_mm_or_si128(x, letters16(x, lo, hi));
+        y=_mm_or_si128(y, letters16(y, lo, hi));
+        unsigned m=(~_mm_movemask_epi8(_mm_cmpeq_epi8(x, y)) | _mm_movemask_epi8(_mm_or_si128(x, y))) & 0xffff;
+        if(m)
+            return a+__builtin_ctz(m);
+    }
+    return ascii_imismatch_scalar(a, e, b);
+}
+
+/////////////////////////////////////////////
+// sse4.2, for sets of up to 16 chars
+
+const int pcmp_any=_SIDD_UBYTE_OPS | _SIDD_CMP_EQUAL_ANY;
+
+__attribute__((target("sse4.2")))
+const char* first_of_sse42(const char* b, const char* e, const char_set& s)
+{
+    if(s.n<=small_set || s.n>16)
+        return first_of_sse2(b, e, s);
+    __m128i set=_mm_loadu_si128((const __m128i*)s.chars);
+    for(; e-b>=16; b+=16){
+        int i=_mm_cmpestri(set, s.n, _mm_loadu_si128((const __m128i*)b), 16,
+                           pcmp_any | _SIDD_LEAST_SIGNIFICANT);
+        if(i<16)
+            return b+i;
+    }
+    return first_of_scalar(b, e, s);
+}
+
+__attribute__((target("sse4.2")))
+const char* first_not_of_sse42(const char* b, const char* e, const char_set& s)
+{
+    if(s.n<=small_set || s.n>16)
+        return first_not_of_sse2(b, e, s);
+    __m128i set=_mm_loadu_si128((const __m128i*)s.chars);
+    for(; e-b>=16; b+=16){
+        int i=_mm_cmpestri(set, s.n, _mm_loadu_si128((const __m128i*)b), 16,
+                           pcmp_any | _SIDD_NEGATIVE_POLARITY | _SIDD_LEAST_SIGNIFICANT);
+        if(i<16)
+            return b+i;
+    }
+    return first_not_of_scalar(b, e, s);
+}
+
+__attribute__((target("sse4.2")))
+const char* last_not_of_sse42(const char* b, const char* e, const char_set& s)
+{
+    if(s.n<=small_set || s.n>16)
+        return last_not_of_sse2(b, e, s);
+    __m128i set=_mm_loadu_si128((const __m128i*)s.chars);
+    for(; e-b>=16; e-=16){
+        int i=_mm_cmpestri(set, s.n, _mm_loadu_si128((const __m128i*)(e-16)), 16,
+                           pcmp_any | _SIDD_NEGATIVE_POLARITY | _SIDD_MOST_SIGNIFICANT);
+        if(i<16)
+            return e-16+i;
+    }
+    return last_not_of_scalar(b, e, s);
+}
+
+/////////////////////////////////////////////
+// avx2
+// gcc doesn't insert vzeroupper in target("avx2") functions, so they clear the upper halves
+// themselves before leaving, or sse code after them pays for the transition.
+
+__attribute__((target("avx2")))
+inline unsigned match32(__m256i x, const __m256i* v, unsigned n)
+{
+    __m256i m=_mm256_cmpeq_epi8(x, v[0]);
+    for(unsigned i=1; i<n; i++)
+        m=_mm256_or_si256(m, _mm256_cmpeq_epi8(x, v[i]));
+    return (unsigned)_mm256_movemask_epi8(m);
+}
+
+__attribute__((target("avx2")))
+const char* first_of_avx2(const char* b, const char* e, const char_set& s)
+{
+    if(s.n>small_set || s.n==0)
+        return first_of_sse42(b, e, s);
+    __m256i v[small_set];
+    for(unsigned i=0; i<s.n; i++)
+        v[i]=_mm256_set1_epi8((char)s.chars[i]);
+    for(; e-b>=32; b+=32){
+        unsigned m=match32(_mm256_loadu_si256((const __m256i*)b), v, s.n);
+        if(m){
+            _mm256_zeroupper();
+            return b+__builtin_ctz(m);
+        }
+    }
+    _mm256_zeroupper();
+    return first_of_sse2(b, e, s);
+}
+
+__attribute__((target("avx2")))
+const char* first_not_of_avx2(const char* b, const char* e, const char_set& s)
+{
+    if(s.n>small_set || s.n==0)
+        return first_not_of_sse42(b, e, s);
+    __m256i v[small_set];
+    for(unsigned i=0; i<s.n; i++)
+        v[i]=_mm256_set1_epi8((char)s.chars[i]);
+    for(; e-b>=32; b+=32){
+        unsigned m=~match32(_mm256_loadu_si256((const __m256i*)b), v, s.n);
+        if(m){
+            _mm256_zeroupper();
+            return b+__builtin_ctz(m);
+        }
+    }
+    _mm256_zeroupper();
+    return first_not_of_sse2(b, e, s);
+}
+
+__attribute__((target("avx2")))
+const char* last_not_of_avx2(const char* b, const char* e, const char_set& s)
+{
+    if(s.n>small_set || s.n==0)
+        return last_not_of_sse42(b, e, s);
+    __m256i v[small_set];
+    for(unsigned i=0; i<s.n; i++)
+        v[i]=_mm256_set1_epi8((char)s.chars[i]);
+    for(; e-b>=32; e-=32){
+        unsigned m=~match32(_mm256_loadu_si256((const __m256i*)(e-32)), v, s.n);
+        if(m){
+            _mm256_zeroupper();
+            return e-32+(31-__builtin_clz(m));
+        }
+    }
+    _mm256_zeroupper();
+    return last_not_of_sse2(b, e, s);
+}
+
+__attribute__((target("avx2")))
+size_t count_avx2(const char* b, const char* e, char c)
+{
+    size_t n=0;
+    __m256i v=_mm256_set1_epi8(c), zero=_mm256_setzero_si256();
+    while(e-b>=32){
+        __m256i acc=_mm256_setzero_si256();
+        size_t k=(size_t)(e-b)/32;
+        if(k>255)
+            k=255;
+        for(size_t i=0; i<k; i++, b+=32)
+            acc=_mm256_sub_epi8(acc, _mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i*)b), v));
+        unsigned long long t[4];
+        _mm256_storeu_si256((__m256i*)t, _mm256_sad_epu8(acc, zero));
+        n+=(size_t)(t[0]+t[1]+t[2]+t[3]);
+    }
+    _mm256_zeroupper();
+    return n+count_sse2(b, e, c);
+}
+
+__attribute__((target("avx2,popcnt")))
+size_t count_tokens_avx2(const char* b, const char* e, const char_set& s, bool after_delim)
+{
+    if(s.n>small_set || s.n==0)
+        return count_tokens_scalar(b, e, s, after_delim);
+    __m256i v[small_set];
+    for(unsigned i=0; i<s.n; i++)
+        v[i]=_mm256_set1_epi8((char)s.chars[i]);
+    size_t n=0;
+    unsigned long long carry=after_delim;
+    for(; e-b>=32; b+=32){
+        unsigned long long m=match32(_mm256_loadu_si256((const __m256i*)b), v, s.n);
+        n+=__builtin_popcountll(~m & ((m<<1) | carry) & 0xffffffffULL);
+        carry=m>>31;
+    }
+    _mm256_zeroupper();
+    return n+count_tokens_sse2(b, e, s, carry);
+}
+
+__attribute__((target("avx2")))
+inline __m256i letters32(__m256i x, __m256i lo, __m256i hi)
+{
+    __m256i out=_mm256_or_si256(_mm256_cmpgt_epi8(lo, x), _mm256_cmpgt_epi8(x, hi));
+    return _mm256_andnot_si256(out, _mm256_set1_epi8(0x20));
+}
+
+__attribute__((target("avx2")))
+const char* ascii_case_avx2(char* d, const char* b, const char* e, bool upper)
+{
+    __m256i lo=_mm256_set1_epi8(upper ? 'a' : 'A'), hi=_mm256_set1_epi8(upper ? 'z' : 'Z');
+    for(; e-b>=32; b+=32, d+=32){
+        __m256i x=_mm256_loadu_si256((const __m256i*)b);
+        if(_mm256_movemask_epi8(x))
+            break;
+        _mm256_storeu_si256((__m256i*)d, _mm256_xor_si256(x, letters32(x, lo, hi)));
+    }
+    _mm256_zeroupper();
+    return ascii_case_sse2(d, b, e, upper);
+}
+
+__attribute__((target("avx2")))
+const char* ascii_imismatch_avx2(const char* a, const char* e, const char* b)
+{
+    __m256i lo=_mm256_set1_epi8('A'), hi=_mm256_set1_epi8('Z');
+    for(; e-a>=32; a+=32, b+=32){
+        __m256i x=_mm256_loadu_si256((const __m256i*)a), y=_mm256_loadu_si256((const __m256i*)b);
+        x=_mm256_or_si256(x, letters32(x, lo, hi));
+        y=_mm256_or_si256(y, letters32(y, lo, hi));
+        unsigned m=~(unsigned)_mm256_movemask_epi8(_mm256_cmpeq_epi8(x, y))
+                   | (unsigned)_mm256_movemask_epi8(_mm256_or_si256(x, y));
+        if(m){
+            _mm256_zeroupper();
+            return a+__builtin_ctz(m);
+        }
+    }
+    _mm256_zeroupper();
+    return ascii_imismatch_sse2(a, e, b);
+}
+
+#endif // PROTON_SCAN_X86
+
+/////////////////////////////////////////////
+// dispatch
+
+struct scan_ops{
+    int level;
+    const char* (*first_of)(const char* b, const char* e, const char_set& s);
+    const char* (*first_not_of)(const char* b, const char* e, const char_set& s);
+    const char* (*last_not_of)(const char* b, const char* e, const char_set& s);
+    size_t (*count)(const char* b, const char* e, char c);
+    const char* (*ascii_case)(char* d, const char* b, const char* e, bool upper);
+    const char* (*ascii_imismatch)(const char* a, const char* e, const char* b);
+    size_t (*count_tokens)(const char* b, const char* e, const char_set& s, bool after_delim);
+};
+
+const scan_ops ops_table[]={
+    {scan_scalar, first_of_scalar, first_not_of_scalar, last_not_of_scalar, count_scalar,
+     ascii_case_scalar, ascii_imismatch_scalar, count_tokens_scalar},
+#ifdef PROTON_SCAN_X86
+    {scan_sse2, first_of_sse2, first_not_of_sse2, last_not_of_sse2, count_sse2,
+     ascii_case_sse2, ascii_imismatch_sse2, count_tokens_sse2},
+    {scan_sse42, first_of_sse42, first_not_of_sse42, last_not_of_sse42, count_sse2,
+     ascii_case_sse2, ascii_imismatch_sse2, count_tokens_sse2},
+    {scan_avx2, first_of_avx2, first_not_of_avx2, last_not_of_avx2, count_avx2,
+     ascii_case_avx2, ascii_imismatch_avx2, count_tokens_avx2},
+#endif
+};
+
+int best_level()
+{
+#ifdef PROTON_SCAN_X86
+    __builtin_cpu_init();
+    if(__builtin_cpu_supports("avx2") && __builtin_cpu_supports("sse4.2"))
+        return scan_avx2;
+    if(__builtin_cpu_supports("sse4.2"))
+        return scan_sse42;
+    if(__builtin_cpu_supports("sse2"))
+        return scan_sse2;
+#endif
+    return scan_scalar;
+}
+
+std::atomic<const scan_ops*> cur_ops(NULL);
+
+inline const scan_ops* ops()
+{
+    const scan_ops* p=cur_ops.load(std::memory_order_relaxed);
+    if(!p){
+        p=&ops_table[best_level()];
+        cur_ops.store(p, std::memory_order_relaxed);
+    }
+    return p;
+}
+
+} // ns
+
+const char* scan_first_of(const char* b, const char* e, const char_set& s)
+{
+    return ops()->first_of(b, e, s);
+}
+
+const char* scan_first_not_of(const char* b, const char* e, const char_set& s)
+{
+    return ops()->first_not_of(b, e, s);
+}
+
+const char* scan_last_not_of(const char* b, const char* e, const char_set& s)
+{
+    return ops()->last_not_of(b, e, s);
+}
+
+size_t scan_count(const char* b, const char* e, char c)
+{
+    return ops()->count(b, e, c);
+}
+
+const char* scan_ascii_case(char* d, const char* b, const char* e, bool upper)
+{
+    return ops()->ascii_case(d, b, e, upper);
+}
+
+const char* scan_ascii_imismatch(const char* a, const char* e, const char* b)
+{
+    return ops()->ascii_imismatch(a, e, b);
+}
+
+size_t scan_count_tokens(const char* b, const char* e, const char_set& s, bool after_delim)
+{
+    return ops()->count_tokens(b, e, s, after_delim);
+}
+
+int scan_level()
+{
+    return ops()->level;
+}
+
+int set_scan_level(int level)
+{
+    int best=best_level();
+    if(level>best)
+        level=best;
+    if(level<0)
+        level=scan_scalar;
+    cur_ops.store(&ops_table[level], std::memory_order_relaxed);
+    return level;
+}
+
+} // ns detail
+
+} // ns proton
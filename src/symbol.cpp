@@ -0,0 +1,145 @@
+#include <mutex>
+#include <cstring>
+#include <proton/base.hpp>
+#include <proton/pool.hpp>
+#include <proton/symbol.hpp>
+
+namespace proton{
+
+namespace detail{
+
+const symbol_entry empty_symbol={0, 0, {NULL}, {0}};
+
+// buckets of a shard, replaced by a doubled one when full.
+// Old buckets are kept, as readers may still be walking them.
+struct symbol_buckets{
+    size_t mask;
+    std::atomic<symbol_entry*> heads[1];
+};
+
+struct symbol_shard{
+    std::mutex lock;
+    std::atomic<symbol_buckets*> buckets;
+    size_t cnt;
+};
+
+constexpr size_t symbol_shard_bits=4;
+constexpr size_t symbol_shard_cnt=1<<symbol_shard_bits;
+constexpr size_t symbol_buckets_initial=64;
+
+static symbol_shard shards[symbol_shard_cnt];
+
+// per_pool is not thread-safe, shards allocate under this lock
+static std::mutex per_pool_lock;
+
+static void* alloc(size_t size)
+{
+    std::lock_guard<std::mutex> g(per_pool_lock);
+    void* p=per_malloc(size);
+    if(!p)
+        throw std::bad_alloc();
+    return p;
+}
+
+static symbol_buckets* new_buckets(size_t n)
+{
+    symbol_buckets* b=(symbol_buckets*)alloc(sizeof(symbol_buckets)+(n-1)*sizeof(std::atomic<symbol_entry*>));
+    b->mask=n-1;
+    for(size_t i=0; i<n; i++)
+        new (&b->heads[i]) std::atomic<symbol_entry*>(NULL);
+    return b;
+}
+
+static std::atomic<symbol_entry*>& bucket(symbol_buckets* b, size_t hash)
+{
+    return b->heads[(hash>>symbol_shard_bits) & b->mask];
+}
+
+static const symbol_entry* lookup(symbol_buckets* b, const char* s, size_t len, size_t hash)
+{
+    if(!b)
+        return NULL;
+    // entries being moved by rehash() may lead to another chain, so callers
+    // without the lock must check a miss again under it
+    const symbol_entry* e=bucket(b, hash).load(std::memory_order_acquire);
+    while(e){
+        if(e->hash==hash && e->len==len && std::memcmp(e->chars, s, len)==0)
+            return e;
+        e=e->next.load(std::memory_order_acquire);
+    }
+    return NULL;
+}
+
+// double the buckets of a locked shard
+static void rehash(symbol_shard& sh)
+{
+    symbol_buckets* old=sh.buckets.load(std::memory_order_relaxed);
+    symbol_buckets* b=new_buckets((old->mask+1)*2);
+    for(size_t i=0; i<=old->mask; i++){
+        symbol_entry* e=old->heads[i].load(std::memory_order_relaxed);
+        while(e){
+            symbol_entry* next=e->next.load(std::memory_order_relaxed);
+            std::atomic<symbol_entry*>& h=bucket(b, e->hash);
+            e->next.store(h.load(std::memory_order_relaxed), std::memory_order_release);
+            h.store(e, std::memory_order_relaxed);
+            e=next;
+        }
+    }
+    sh.buckets.store(b, std::memory_order_release);
+}
+
+const symbol_entry* find_symbol(const char* s, size_t len, size_t hash)
+{
+    symbol_shard& sh=shards[hash & (symbol_shard_cnt-1)];
+    const symbol_entry* r=lookup(sh.buckets.load(std::memory_order_acquire), s, len, hash);
+    if(r)
+        return r;
+    std::lock_guard<std::mutex> g(sh.lock);
+    return lookup(sh.buckets.load(std::memory_order_relaxed), s, len, hash);
+}
+
+const symbol_entry* intern(const char* s, size_t len, size_t hash)
+{
+    symbol_shard& sh=shards[hash & (symbol_shard_cnt-1)];
+    const symbol_entry* r=lookup(sh.buckets.load(std::memory_order_acquire), s, len, hash);
+    if(r)
+        return r;
+
+    std::lock_guard<std::mutex> g(sh.lock);
+    symbol_buckets* b=sh.buckets.load(std::memory_order_relaxed);
+    if(!b){
+        b=new_buckets(symbol_buckets_initial);
+        sh.buckets.store(b, std::memory_order_release);
+    }
+    r=lookup(b, s, len, hash);
+    if(r)
+        return r;
+
+    symbol_entry* e=(symbol_entry*)alloc(offsetof(symbol_entry, chars)+len+1);
+    e->hash=hash;
+    e->len=len;
+    std::memcpy(e->chars, s, len);
+    e->chars[len]='\0';
+    std::atomic<symbol_entry*>& h=bucket(b, hash);
+    new (&e->next) std::atomic<symbol_entry*>(h.load(std::memory_order_relaxed));
+    h.store(e, std::memory_order_release);
+    if(++sh.cnt > b->mask+1)
+        rehash(sh);
+    return e;
+}
+
+} // ns detail
+
+using namespace detail;
+
+size_t symbol_count()
+{
+    size_t n=0;
+    for(auto& sh: shards){
+        std::lock_guard<std::mutex> g(sh.lock);
+        n+=sh.cnt;
+    }
+    return n;
+}
+
+} // ns proton
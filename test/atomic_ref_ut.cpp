@@ -0,0 +1,123 @@
+#include <iostream>
+#include <thread>
+#include <vector>
+#include <atomic>
+#include <proton/base.hpp>
+#include <proton/ref.hpp>
+#include <proton/atomic_ref.hpp>
+#include <proton/detail/unit_test.hpp>
+
+using namespace std;
+using namespace proton;
+
+std::atomic<long> live_count(0);
+
+struct obj_table{
+    long a;
+    long b;
+
+    obj_table(long x):a(x),b(-x)
+    {
+        live_count++;
+    }
+
+    obj_table(const obj_table& x):a(x.a),b(x.b)
+    {
+        live_count++;
+    }
+
+    ~obj_table()
+    {
+        a=1;
+        b=1;
+        live_count--;
+    }
+};
+
+typedef aref_<obj_table> table;
+
+int api_ut()
+{
+    cout << "-> api_ut" << endl;
+    {
+        atomic_ref_<table> cell;
+        PROTON_THROW_IF(cell.load()!=none, "err");
+
+        table t1(1), t2(2), t3(3);
+        cell.store(t1);
+        PROTON_THROW_IF(cell.load()->a!=1, "err");
+        PROTON_THROW_IF(ref_count(t1)!=2, "err");
+
+        table old=cell.exchange(t2);
+        PROTON_THROW_IF(old->a!=1 || cell.load()->a!=2, "err");
+        PROTON_THROW_IF(ref_count(t1)!=2, "err");
+
+        table expected=t1;
+        PROTON_THROW_IF(cell.compare_exchange(expected, t3), "err");
+        PROTON_THROW_IF(expected->a!=2, "err");
+        PROTON_THROW_IF(!cell.compare_exchange(expected, t3), "err");
+        PROTON_THROW_IF(cell.load()->a!=3, "err");
+
+        cell.store(none);
+        PROTON_THROW_IF(cell.load()!=none, "err");
+        PROTON_THROW_IF(ref_count(t3)!=1, "err");
+        cell.store(t3);
+    }
+    PROTON_THROW_IF(live_count!=0, "leak");
+    return 0;
+}
+
+int threads_ut()
+{
+    cout << "-> threads_ut" << endl;
+    {
+        atomic_ref_<table> cell(table(0));
+        std::atomic<bool> stop(false);
+        std::atomic<long> bad(0);
+
+        std::vector<std::thread> readers;
+        for(int i=0; i<4; i++){
+            readers.push_back(std::thread([&](){
+                long last=0;
+                while(!stop){
+                    table t=cell.load();
+                    if(t->a!=-t->b || t->a<last)
+                        bad++;
+                    last=t->a;
+                }
+            }));
+        }
+
+        std::thread cas_writer([&](){
+            for(long i=0; i<20000; i++){
+                table t=cell.load();
+                cell.compare_exchange(t, t);
+            }
+        });
+
+        for(long i=1; i<=50000; i++){
+            if(i%2)
+                cell.store(table(i));
+            else
+                cell.exchange(table(i));
+        }
+        cas_writer.join();
+        stop=true;
+        for(auto& t: readers)
+            t.join();
+
+        PROTON_THROW_IF(bad!=0, "bad snapshot");
+        PROTON_THROW_IF(cell.load()->a!=50000, "err");
+    }
+    PROTON_THROW_IF(live_count!=0, "leak");
+    return 0;
+}
+
+int main()
+{
+    proton::debug_level=1;
+    proton::wait_on_err=0;
+    std::vector<proton::detail::unittest_t> ut=
+        {api_ut, threads_ut};
+    return proton::detail::unittest_run(ut);
+}
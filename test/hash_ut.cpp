@@ -0,0 +1,140 @@
+#include <iostream>
+#include <vector>
+#include <string>
+#include <tuple>
+#include <cstdlib>
+#include <cstring>
+#include <proton/base.hpp>
+#include <proton/string.hpp>
+#include <proton/small_string.hpp>
+#include <proton/symbol.hpp>
+#include <proton/vector.hpp>
+#include <proton/set.hpp>
+#include <proton/tuple.hpp>
+#include <proton/unordered_map.hpp>
+#include <proton/unordered_set.hpp>
+#include <proton/hash.hpp>
+#include <proton/detail/unit_test.hpp>
+
+using namespace std;
+using namespace proton;
+
+int bytes_ut()
+{
+    cout << "-> bytes_ut" << endl;
+    // every length through the short and the 16/48 byte loops, at every offset
+    std::vector<char> buf(300);
+    for(size_t i=0; i<buf.size(); i++)
+        buf[i]=(char)(rand()%256);
+    unordered_set_<size_t> seen;
+    for(size_t n=0; n<=200; n++){
+        size_t h=hash_bytes(buf.data(), n);
+        PROTON_THROW_IF(h!=hash_bytes(buf.data(), n), "stable " << n);
+        std::vector<char> copy(buf.begin(), buf.begin()+n);
+        for(size_t k=1; k<8; k++){
+            std::vector<char> moved(k, 'x');
+            moved.insert(moved.end(), copy.begin(), copy.end());
+            PROTON_THROW_IF(hash_bytes(moved.data()+k, n)!=h, "unaligned " << n << " " << k);
+        }
+        seen.insert(h);
+        if(n){
+            // a change of any byte changes the hash
+            for(size_t i=0; i<n; i+=(n>20 ? 7 : 1)){
+                copy[i]^=1;
+                PROTON_THROW_IF(hash_bytes(copy.data(), n)==h, "byte " << i << " of " << n);
+                copy[i]^=1;
+            }
+        }
+    }
+    PROTON_THROW_IF(seen.size()!=201, "collisions among prefixes");
+
+    // zero bytes of different lengths differ
+    std::vector<char> zeros(64, 0);
+    seen.clear();
+    for(size_t n=0; n<=64; n++)
+        seen.insert(hash_bytes(zeros.data(), n));
+    PROTON_THROW_IF(seen.size()!=65, "zeros");
+
+    // seeds
+    PROTON_THROW_IF(hash_bytes("key", 3, 1)==hash_bytes("key", 3, 2)
+                    || hash_bytes("key", 3)!=hash_bytes("key", 3, detail::hash_seed), "seed");
+    PROTON_THROW_IF(hash_combine(1, 2)==hash_combine(2, 1), "combine order");
+    return 0;
+}
+
+int str_ut()
+{
+    cout << "-> str_ut" << endl;
+    // every proton string type hashes the same chars to the same value
+    str z(1000, 'z');
+    for(auto s: {"", "a", "hello", "a somewhat longer key, past sixteen", z.c_str()}){
+        size_t h=std::hash<str>()(s);
+        PROTON_THROW_IF(std::hash<str_view>()(s)!=h || std::hash<small_str>()(small_str(s))!=h
+                        || std::hash<symbol>()(symbol(s))!=h, "str types " << s);
+        PROTON_THROW_IF(h!=hash_bytes(s, strlen(s)), "hash_bytes " << s);
+    }
+    // unqualified under both using directives
+    PROTON_THROW_IF(hash<str>()(z)!=hasher<str>()(z), "hash<str>");
+    wstr w=L"wide";
+    PROTON_THROW_IF(std::hash<wstr>()(w)!=std::hash<wstr_view>()(w), "wide");
+
+    // few collisions among short keys
+    unordered_set_<size_t> seen;
+    size_t n=0;
+    for(int i=0; i<20000; i++, n++)
+        seen.insert(std::hash<str>()(to_<str>(i)));
+    for(char a='a'; a<='z'; a++){
+        for(char b='a'; b<='z'; b++, n++)
+            seen.insert(std::hash<str>()(str({a, b})));
+    }
+    PROTON_THROW_IF(seen.size()!=n, "collisions " << n-seen.size());
+    return 0;
+}
+
+int key_ut()
+{
+    cout << "-> key_ut" << endl;
+    vector_<int> a={1,2,3}, b={1,2,3}, c={3,2,1};
+    PROTON_THROW_IF(std::hash<vector_<int> >()(a)!=std::hash<vector_<int> >()(b)
+                    || std::hash<vector_<int> >()(a)==std::hash<vector_<int> >()(c), "vector_");
+    vector_<str> p={"ab", "c"}, q={"a", "bc"};
+    PROTON_THROW_IF(std::hash<vector_<str> >()(p)==std::hash<vector_<str> >()(q), "vector_ of str");
+    vector_<bool> bits={true, false, true};
+    PROTON_THROW_IF(std::hash<vector_<bool> >()(bits)==std::hash<vector_<bool> >()(vector_<bool>({true, true, false})),
+                    "vector_<bool>");
+    PROTON_THROW_IF(std::hash<vector_<int> >()(vector_<int>())==std::hash<vector_<int> >()(vector_<int>({0})), "empty");
+
+    set_<str> s={"x", "y"};
+    PROTON_THROW_IF(std::hash<set_<str> >()(s)!=std::hash<set_<str> >()(set_<str>({"y", "x"})), "set_");
+
+    auto t=_t(str("k"), 1, vector_<int>({1,2}));
+    typedef decltype(t) key_t;
+    PROTON_THROW_IF(hasher<key_t>()(t)!=hasher<key_t>()(_t(str("k"), 1, vector_<int>({1,2})))
+                    || hasher<key_t>()(t)==hasher<key_t>()(_t(str("k"), 2, vector_<int>({1,2}))), "tuple");
+    typedef std::tuple<int,int> pair_t;
+    PROTON_THROW_IF(hasher<pair_t>()(_t(1,2))==hasher<pair_t>()(_t(2,1)), "tuple order");
+
+    // composite keys of unordered containers
+    unordered_map_<key_t, int> m;
+    for(int i=0; i<1000; i++)
+        m[_t(to_<str>(i%10), i, vector_<int>({i, -i}))]=i;
+    PROTON_THROW_IF(m.size()!=1000 || m[_t(str("7"), 77, vector_<int>({77, -77}))]!=77, "tuple key");
+    unordered_map_<std::tuple<str, std::tuple<int, set_<str> > >, int> nested;
+    nested[_t(str("a"), _t(1, s))]=1;
+    nested[_t(str("a"), _t(1, set_<str>({"x"})))]=2;
+    PROTON_THROW_IF(nested.size()!=2 || nested[_t(str("a"), _t(1, set_<str>({"y", "x"})))]!=1, "nested key");
+    unordered_set_<vector_<str> > vs={p, q, p};
+    PROTON_THROW_IF(vs.size()!=2, "vector_ key");
+    unordered_set_<vector_<pair_t> > vt={{_t(1,2)}, {_t(2,1)}, {_t(1,2)}};
+    PROTON_THROW_IF(vt.size()!=2, "vector_ of tuples key");
+    return 0;
+}
+
+int main()
+{
+    proton::debug_level=1;
+    proton::wait_on_err=0;
+    std::vector<proton::detail::unittest_t> ut=
+        {bytes_ut, str_ut, key_ut};
+    return proton::detail::unittest_run(ut);
+}
@@ -0,0 +1,279 @@
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <vector>
+#include <cstdio>
+#include <fcntl.h>
+#include <unistd.h>
+#include <proton/base.hpp>
+#include <proton/string.hpp>
+#include <proton/vector.hpp>
+#include <proton/deque.hpp>
+#include <proton/list.hpp>
+#include <proton/map.hpp>
+#include <proton/set.hpp>
+#include <proton/unordered_map.hpp>
+#include <proton/tuple.hpp>
+#include <proton/small_string.hpp>
+#include <proton/symbol.hpp>
+#include <proton/io.hpp>
+#include <proton/detail/unit_test.hpp>
+
+using namespace std;
+using namespace proton;
+
+// lines by readline(), the reference of line_reader
+vector<str> stream_lines(const str& s, char delim='\n')
+{
+    vector<str> r;
+    istringstream i(s);
+    while(1){
+        str line=readline(i, delim);
+        if(line.empty())
+            break;
+        r.push_back(line);
+    }
+    return r;
+}
+
+str make_text(size_t lines, bool last_delim)
+{
+    str s;
+    for(size_t i=0; i<lines; i++){
+        s+=str(i*7%50, 'a'+i%26);
+        if(i%5==0)
+            s+=str(300, 'x'); // longer than small buffers
+        if(i+1<lines || last_delim)
+            s+="\n";
+    }
+    return s;
+}
+
+int readline_ut()
+{
+    cout << "-> readline_ut" << endl;
+    vector<str> l=stream_lines("a\n\nbc\nd");
+    PROTON_THROW_IF(l.size()!=4 || l[0]!="a\n" || l[1]!="\n" || l[2]!="bc\n" || l[3]!="d", "err");
+    l=stream_lines("a;b;", ';');
+    PROTON_THROW_IF(l.size()!=2 || l[1]!="b;", "delim");
+    PROTON_THROW_IF(!stream_lines("").empty(), "empty");
+    return 0;
+}
+
+int line_reader_ut()
+{
+    cout << "-> line_reader_ut" << endl;
+    const char* fn="io_ut.tmp";
+    for(bool last_delim: {true, false}){
+        for(size_t lines: {0, 1, 2, 100}){
+            str s=make_text(lines, last_delim);
+            vector<str> ref=stream_lines(s);
+            {
+                ofstream f(fn, ios_base::binary);
+                f << s;
+            }
+            for(size_t buf_size: {16, 100, 65536}){
+                // a file, a fd and a stream
+                for(int src=0; src<3; src++){
+                    int fd=-1;
+                    ifstream in;
+                    std::unique_ptr<line_reader> r;
+                    if(src==0)
+                        r.reset(new line_reader(fn, '\n', buf_size));
+                    else if(src==1){
+                        fd=::open(fn, O_RDONLY);
+                        r.reset(new line_reader(fd, '\n', buf_size));
+                    }
+                    else{
+                        in.open(fn, ios_base::binary);
+                        r.reset(new line_reader(in, '\n', buf_size));
+                    }
+                    size_t i=0, offset=0;
+                    for(auto line: *r){
+                        PROTON_THROW_IF(i>=ref.size() || line!=ref[i], "line " << i << " of " << lines << " by " << src);
+                        offset+=line.size();
+                        PROTON_THROW_IF(r->offset()!=offset, "offset");
+                        i++;
+                    }
+                    PROTON_THROW_IF(i!=ref.size() || r->offset()!=s.size(), "lines " << lines << " by " << src);
+                    str_view v;
+                    PROTON_THROW_IF(r->next(v), "read after the end");
+                    if(fd>=0)
+                        ::close(fd);
+                }
+            }
+        }
+    }
+
+    istringstream i("k=1;k=2;rest");
+    line_reader r(i, ';');
+    PROTON_THROW_IF(readline(r)!="k=1;" || readline(r)!="k=2;" || readline(r)!="rest" || readline(r)!="", "readline");
+    std::remove(fn);
+
+    try{
+        line_reader x("no_such_dir/no_such_file");
+        PROTON_THROW_IF(true, "no error");
+    }
+    catch(std::system_error&){
+    }
+    return 0;
+}
+
+int mapped_file_ut()
+{
+    cout << "-> mapped_file_ut" << endl;
+    const char* fn="io_ut.tmp";
+    for(size_t lines: {0, 1, 100}){
+        str s=make_text(lines, lines%2);
+        {
+            ofstream f(fn, ios_base::binary);
+            f << s;
+        }
+        mapped_file m(fn);
+        PROTON_THROW_IF(str_view(m)!=s || m.mapped()!=(lines>0), "contents");
+        vector<str> ref=stream_lines(s);
+        size_t i=0;
+        for(auto line: m.lines()){
+            PROTON_THROW_IF(i>=ref.size() || line!=ref[i], "line " << i);
+            i++;
+        }
+        PROTON_THROW_IF(i!=ref.size(), "lines");
+        deque_<str> words=str(s).split();
+        PROTON_THROW_IF(m.isplit().size()!=words.size() || !std::equal(words.begin(), words.end(), m.isplit().begin()),
+                        "fields");
+    }
+
+    {
+        ofstream f(fn, ios_base::binary);
+        f << "id, name ,value\n1, a, 10\n";
+    }
+    mapped_file m(fn);
+    vector_<str_view> fields;
+    for(auto line: m.lines())
+        for(auto field: isplit(line, ",\n", 1))
+            fields.push_back(strip(field));
+    PROTON_THROW_IF(fields.size()!=6 || fields[1]!="name" || fields[5]!="10", "csv");
+    PROTON_THROW_IF(fields[4].data()<m.data() || fields[4].data()>=m.end(), "not a view into the mapping");
+    mapped_file x(std::move(m));
+    PROTON_THROW_IF(!m.empty() || x.size()!=25 || !x.mapped(), "move");
+
+    // a file descriptor is mapped from its position, like a pipe is read
+    str big=make_text(2000, true);
+    {
+        ofstream f(fn, ios_base::binary);
+        f << big;
+    }
+    for(size_t pos: {(size_t)0, (size_t)1, (size_t)4096, (size_t)5000, big.size()-1, big.size()}){
+        int fd=::open(fn, O_RDONLY);
+        PROTON_THROW_IF(fd<0 || ::lseek(fd, pos, SEEK_SET)!=(off_t)pos, "open");
+        {
+            mapped_file f(fd);
+            PROTON_THROW_IF(str_view(f)!=big.view(pos) || f.mapped()!=(pos<big.size()), "position " << pos);
+            PROTON_THROW_IF(::lseek(fd, 0, SEEK_CUR)!=(off_t)big.size(), "left at the end " << pos);
+        }
+        ::close(fd);
+    }
+    std::remove(fn);
+
+    // pipes are read into a buffer
+    int fds[2];
+    PROTON_THROW_IF(::pipe(fds)!=0, "pipe");
+    str s=make_text(50, true);
+    PROTON_THROW_IF(::write(fds[1], s.data(), s.size())!=(ssize_t)s.size(), "write");
+    ::close(fds[1]);
+    mapped_file p(fds[0]);
+    ::close(fds[0]);
+    PROTON_THROW_IF(p.mapped() || str_view(p)!=s, "pipe");
+
+    try{
+        mapped_file y("no_such_dir/no_such_file");
+        PROTON_THROW_IF(true, "no error");
+    }
+    catch(std::system_error&){
+    }
+    return 0;
+}
+
+struct point{
+    int x, y;
+};
+
+std::ostream& operator<<(std::ostream& s, const point& p)
+{
+    return s << "<" << p.x << "," << p.y << ">";
+}
+
+// the same output by out_buffer and by ostream
+template<typename T>
+bool same_output(const T& x)
+{
+    std::ostringstream ref, s;
+    ref << x;
+    {
+        out_buffer o(s, 64);
+        o << x;
+    }
+    if(s.str()!=ref.str()){
+        cout << s.str() << " vs " << ref.str() << endl;
+        return false;
+    }
+    return true;
+}
+
+int out_buffer_ut()
+{
+    cout << "-> out_buffer_ut" << endl;
+    PROTON_THROW_IF(!same_output(0) || !same_output(-12345L) || !same_output(~0ULL) || !same_output((short)-7)
+                    || !same_output(true) || !same_output('c') || !same_output((unsigned char)'u'), "ints");
+    PROTON_THROW_IF(!same_output(1.5) || !same_output(1e-20) || !same_output(0.1f) || !same_output(2.5L), "floats");
+    PROTON_THROW_IF(!same_output("lit") || !same_output(str("str")) || !same_output(std::string(100, 's'))
+                    || !same_output(str_view("view")) || !same_output(small_str("small")), "strings");
+    PROTON_THROW_IF(!same_output(symbol("sym")) || !same_output(point{1, 2}), "others");
+
+    vector_<long> v;
+    for(long i=0; i<1000; i++)
+        v.push_back(i*i-500);
+    map_<str, long> m;
+    for(long i=0; i<100; i++)
+        m[to_<str>(i*7)]=i;
+    PROTON_THROW_IF(!same_output(v) || !same_output(m) || !same_output(vector_<long>()), "containers");
+    PROTON_THROW_IF(!same_output(deque_<str>({"a", "b"})) || !same_output(set_<int>({3, 1, 2}))
+                    , "containers");
+    std::ostringstream ls;
+    {
+        out_buffer o(ls);
+        o << std::list<double>({0.5, 2});
+    }
+    PROTON_THROW_IF(ls.str()!="[0.5, 2]", "list");
+    unordered_map_<int, vector_<str> > u;
+    u[1]={"x", "y"};
+    u[2]={};
+    PROTON_THROW_IF(!same_output(u) || !same_output(_t(1, "a", 2.5, vector_<point>({point{3, 4}}))), "nested");
+    PROTON_THROW_IF(!same_output(std::tuple<>()) || !same_output(_t(str("one"))), "tuples");
+
+    // to a fd, with writes larger than the buffer
+    int fds[2];
+    PROTON_THROW_IF(::pipe(fds)!=0, "pipe");
+    str big(1000, 'b');
+    {
+        out_buffer o(fds[1], 100);
+        o << "head " << 42 << '\n' << big << '\n';
+        o.flush();
+        PROTON_THROW_IF(o.size()!=0, "flush");
+        o << "tail";
+    }
+    ::close(fds[1]);
+    mapped_file r(fds[0]);
+    ::close(fds[0]);
+    PROTON_THROW_IF(str_view(r)!="head 42\n"+big+"\ntail", "fd");
+    return 0;
+}
+
+int main()
+{
+    proton::debug_level=1;
+    proton::wait_on_err=0;
+    std::vector<proton::detail::unittest_t> ut=
+        {readline_ut, line_reader_ut, mapped_file_ut, out_buffer_ut};
+    return proton::detail::unittest_run(ut);
+}
@@ -1,10 +1,20 @@
 #include <iostream>
 #include <proton/base.hpp>
 #include <proton/ref.hpp>
+#include <proton/string.hpp>
+#include <proton/vector.hpp>
+#include <proton/deferred.hpp>
+#include <proton/cycle.hpp>
+#include <proton/uref.hpp>
+#include <proton/weak.hpp>
+#include <proton/atomic_ref.hpp>
 #include <proton/detail/unit_test.hpp>
 #include "pool_types.hpp"
 #include <vector>
 #include <map>
+#include <unordered_set>
+#include <thread>
+#include <chrono>
 
 using namespace std;
 using namespace proton;
@@ -234,12 +244,530 @@ int stl_ut()
     return 0;
 }
 
+typedef ref_<str> rstr;
+typedef ref_<vector_<int> > rvec;
+
+int move_op_ut()
+{
+    cout << "-> move_op_ut" << endl;
+    rstr a("abc"), b("def"), c("g");
+
+    rstr d=a+b+c;
+    PROTON_THROW_IF(*d!="abcdefg", "err");
+    PROTON_THROW_IF(*a!="abc" || *b!="def", "err");
+
+    rstr t=a+b;
+    const str* p=&*t;
+    rstr u=std::move(t)+c;
+    PROTON_THROW_IF(&*u!=p, "the temporary is not reused");
+    PROTON_THROW_IF(*u!="abcdefg", "err");
+
+    rstr s=a+b;
+    rstr s1=s;
+    rstr v=std::move(s)+c;
+    PROTON_THROW_IF(&*v==&*s1, "a shared object is changed in place");
+    PROTON_THROW_IF(*s1!="abcdef" || *v!="abcdefg", "err");
+
+    rstr w=(a+"-")*2;
+    PROTON_THROW_IF(*w!="abc-abc-", "err");
+
+    rstr f=rstr("%d-%s")+"!";
+    p=&*f;
+    rstr g=std::move(f) % _t(1,"x");
+    PROTON_THROW_IF(*g!="1-x!" || &*g!=p, "err");
+
+    rstr h=concat(a, b, c, str("hi"));
+    PROTON_THROW_IF(*h!="abcdefghi", "err");
+    PROTON_THROW_IF(h->capacity()<9, "err");
+
+    rvec x(alloc, {1,2}), y(alloc, {3});
+    rvec z=concat(x, y, x);
+    PROTON_THROW_IF(*z!=vector_<int>({1,2,3,1,2}), "err");
+    return 0;
+}
+
+struct obj_throw{
+    obj_throw(int a)
+    {
+        throw std::runtime_error("obj_throw");
+    }
+};
+
+struct obj_fwd{
+    str s;
+    bool copied;
+
+    obj_fwd(const str& x):s(x),copied(true)
+    {}
+
+    obj_fwd(str&& x):s(std::move(x)),copied(false)
+    {}
+};
+
+int make_ref_ut()
+{
+    cout << "-> make_ref_ut" << endl;
+    str a("a long string to avoid the short string optimization");
+    auto x=make_ref<obj_fwd>(std::move(a));
+    PROTON_THROW_IF(x->copied || x->s.size()!=52, "args are not forwarded");
+    auto y=make_ref<obj_fwd>(x->s);
+    PROTON_THROW_IF(!y->copied, "err");
+
+    rstr s=make_ref<rstr>(3, 'c');
+    PROTON_THROW_IF(*s!="ccc", "err");
+
+    mem_pool pool;
+    size_t f1;
+    {
+        auto r=allocate_ref<obj_refc_test>(pool, 5);
+        PROTON_THROW_IF(r->a!=5 || refc_count!=1, "err");
+        f1=pool.get_seg_free();
+        PROTON_THROW_IF(f1==pool.get_seg_total(), "not allocated in the pool");
+        auto c=allocate_ref<rstr>(pool, "abc")+"d";
+        PROTON_THROW_IF(*c!="abcd", "err");
+    }
+    PROTON_THROW_IF(refc_count!=0, "err");
+    size_t f0=pool.get_seg_free();
+    PROTON_THROW_IF(f0<=f1, "chunk leaked");
+
+    bool caught=false;
+    try{
+        allocate_ref<obj_throw>(pool, 1);
+    }
+    catch(const std::runtime_error&){
+        caught=true;
+    }
+    PROTON_THROW_IF(!caught, "err");
+    PROTON_THROW_IF(pool.get_seg_free()!=f0, "chunk leaked on exceptions");
+
+    // aref_ frees by sys_free(), so allocate_ref<aref_<T> >() doesn't compile
+    PROTON_THROW_IF(detail::frees_by_pool<aref_<obj_refc_test>::alloc_t>::value
+                    || !detail::frees_by_pool<rstr::alloc_t>::value, "pool allocators");
+    return 0;
+}
+
+volatile int tree_count=0;
+
+struct obj_tree;
+typedef dref_<obj_tree> tree;
+
+struct obj_tree{
+    vector_<tree> children;
+
+    obj_tree()
+    {
+        tree_count++;
+    }
+
+    ~obj_tree()
+    {
+        tree_count--;
+    }
+};
+
+typedef ref_<obj_tree, sys_allocator<obj_tree>, ref_traits<obj_tree>,
+        detail::drefc_t<detail::arefc_t> > atree;
+
+int deferred_ut()
+{
+    cout << "-> deferred_ut" << endl;
+    {
+        tree root(alloc);
+        for(int i=0; i<3; i++){
+            tree c(alloc);
+            c->children.push_back(tree(alloc));
+            root->children.push_back(c);
+        }
+        PROTON_THROW_IF(tree_count!=7, "err");
+    }
+    PROTON_THROW_IF(tree_count!=7, "destroyed too early");
+    PROTON_THROW_IF(retired_count()!=1, "err");
+
+    PROTON_THROW_IF(collect(2)!=2, "err");
+    PROTON_THROW_IF(tree_count!=5, "err");
+    PROTON_THROW_IF(retired_count()!=3, "err");
+
+    PROTON_THROW_IF(collect()!=5, "err");
+    PROTON_THROW_IF(tree_count!=0 || retired_count()!=0, "err");
+    PROTON_THROW_IF(collect()!=0, "err");
+
+    {
+        reclaimer rc(1);
+        for(int i=0; i<100; i++)
+            atree t(alloc);
+    }
+    PROTON_THROW_IF(tree_count!=0 || retired_count()!=0, "err");
+
+    // a reclaimer leaves objects of the pools of this thread to it
+    {
+        reclaimer rc(1);
+        {
+            tree t(alloc);
+            t->children.push_back(tree(alloc));
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        PROTON_THROW_IF(tree_count!=2 || retired_count()!=1, "collected in another thread");
+    }
+    PROTON_THROW_IF(tree_count!=0 || retired_count()!=0, "not collected by the dtor");
+    return 0;
+}
+
+struct obj_expr{
+    PROTON_TYPE_ROOT(obj_expr)
+    virtual ~obj_expr()
+    {}
+};
+
+struct obj_num:obj_expr{
+    PROTON_TYPE_DERIVED(obj_num, obj_expr)
+    int v;
+    obj_num(int x):v(x)
+    {}
+};
+
+struct obj_neg:obj_num{
+    PROTON_TYPE_DERIVED(obj_neg, obj_num)
+    obj_neg(int x):obj_num(-x)
+    {}
+};
+
+struct obj_add:obj_expr{
+    PROTON_TYPE_DERIVED(obj_add, obj_expr)
+    ref_<obj_expr> l, r;
+    obj_add(const ref_<obj_expr>& x, const ref_<obj_expr>& y):l(x), r(y)
+    {}
+};
+
+// untagged, cast by dynamic_cast
+struct obj_zero:obj_num{
+    obj_zero():obj_num(0)
+    {}
+};
+
+// an untagged base above a type root, cast by dynamic_cast
+struct obj_any{
+    virtual ~obj_any()
+    {}
+};
+
+struct obj_leaf:obj_any{
+    PROTON_TYPE_ROOT(obj_leaf)
+};
+
+typedef ref_<obj_expr> expr;
+typedef ref_<obj_num> num;
+typedef ref_<obj_neg> neg;
+typedef ref_<obj_add> add;
+typedef ref_<obj_zero> zero;
+
+struct eval_f{
+    int operator()(const add& x)const;
+
+    int operator()(const num& x)const
+    {
+        return x->v;
+    }
+
+    int operator()(const expr& x)const
+    {
+        return 0;
+    }
+};
+
+int eval_f::operator()(const add& x)const
+{
+    return visit<add, num>(x->l, *this) + visit<add, num>(x->r, *this);
+}
+
+int type_tag_ut()
+{
+    cout << "-> type_tag_ut" << endl;
+    PROTON_THROW_IF(type_tag_of<obj_neg>()->depth!=2, "err");
+    PROTON_THROW_IF(type_tag_of<obj_neg>()->display[0]!=type_tag_of<obj_expr>(), "err");
+
+    expr a=neg(alloc, 2), b=num(alloc, 3), z=zero(alloc);
+    expr c=add(alloc, a, add(alloc, b, z));
+    PROTON_THROW_IF(!isinstance<num>(a) || !isinstance<neg>(a) || isinstance<add>(a), "err");
+    PROTON_THROW_IF(isinstance<neg>(b) || !isinstance<zero>(z) || !isinstance<num>(z), "err");
+    PROTON_THROW_IF(isinstance<num>(expr()), "err");
+    PROTON_THROW_IF(cast<num>(a)->v!=-2 || cast<neg>(a)->v!=-2, "err");
+    PROTON_THROW_IF(ref_count(a)!=2, "err");
+    PROTON_THROW_IF(cast<num>(z)->v!=0, "err");
+
+    bool k=false;
+    try{
+        cast<neg>(b);
+    }
+    catch(std::bad_cast&){
+        k=true;
+    }
+    PROTON_THROW_IF(!k, "no cast err detected!");
+
+    PROTON_THROW_IF((visit<add, num>(c, eval_f())!=1), "err");
+    PROTON_THROW_IF((visit<add, num>(expr(alloc), eval_f())!=0), "err");
+
+    ref_<obj_any> n=ref_<obj_leaf>(alloc), m(alloc);
+    PROTON_THROW_IF(!isinstance<ref_<obj_leaf> >(n) || isinstance<ref_<obj_leaf> >(m), "untagged base");
+    PROTON_THROW_IF(ref_count(cast<ref_<obj_leaf> >(n))!=2, "untagged base cast");
+    return 0;
+}
+
+int key_calls=0, eq_calls=0;
+
+struct obj_hkey{
+    str s;
+
+    obj_hkey(const char* x):s(x)
+    {}
+
+    const str& key()const
+    {
+        key_calls++;
+        return s;
+    }
+
+    bool operator==(const obj_hkey& y)const
+    {
+        eq_calls++;
+        return s==y.s;
+    }
+};
+
+typedef href_<obj_hkey> hkey;
+
+int hash_ut()
+{
+    cout << "-> hash_ut" << endl;
+    std::unordered_set<hkey, key_hash<hkey> > s;
+    for(int i=0; i<100; i++)
+        s.insert(hkey(alloc, to_<str>(i).c_str()));
+    PROTON_THROW_IF(s.size()!=100 || key_calls!=100, "err");
+    s.rehash(1000);
+    PROTON_THROW_IF(key_calls!=100, "hash not cached");
+
+    hkey a(alloc, "5"), b(alloc, "abc");
+    PROTON_THROW_IF(s.count(a)!=1 || s.count(b)!=0, "err");
+    PROTON_THROW_IF(key_calls!=102, "err");
+    s.count(a);
+    PROTON_THROW_IF(key_calls!=102, "err");
+
+    // different cached hashes
+    eq_calls=0;
+    PROTON_THROW_IF(a==b, "err");
+    PROTON_THROW_IF(eq_calls!=0, "not rejected by the hash");
+    hkey c(alloc, "abc");
+    PROTON_THROW_IF(!(c==b) || eq_calls!=1, "err");
+
+    PROTON_THROW_IF(key_hash<hkey>()(a)!=std::hash<str>()(a->s), "err");
+    PROTON_THROW_IF(key_hash<hkey>()(hkey())!=0, "err");
+
+    // operators changing a temporary in place drop its cached hash
+    typedef href_<str> hstr;
+    std::hash<hstr> h;
+    hstr k(alloc, "a"), o(alloc, "ab"), oo(alloc, "abab");
+    h(k);
+    h(o);
+    h(oo);
+    hstr k2=std::move(k)+hstr(alloc, "b");
+    PROTON_THROW_IF(!(k2==o) || h(k2)!=h(o), "stale hash after +");
+    hstr k4=std::move(k2)*2;
+    PROTON_THROW_IF(!(k4==oo) || h(k4)!=h(oo), "stale hash after *");
+    return 0;
+}
+
+int cow_copies=0;
+
+struct obj_cow{
+    int v;
+
+    obj_cow(int x):v(x)
+    {}
+
+    obj_cow(const obj_cow& x):v(x.v)
+    {
+        cow_copies++;
+    }
+
+    PROTON_COPY_DECL_NV(obj_cow)
+};
+
+int cow_ut()
+{
+    cout << "-> cow_ut" << endl;
+    typedef cowref_<vector_<int> > cvec;
+    cvec a(alloc);
+    a->push_back(1);
+    a->push_back(2);
+    cvec b=a;
+    const cvec& ca=a, &cb=b;
+    PROTON_THROW_IF(cb[0]!=1 || &*cb!=&*ca || ref_count(a)!=2, "const access cloned");
+
+    b->push_back(3);
+    PROTON_THROW_IF(ref_count(a)!=1 || ref_count(b)!=1, "err");
+    PROTON_THROW_IF(a->size()!=2 || b->size()!=3, "err");
+    const vector_<int>* p=&*b;
+    b[0]=5;
+    PROTON_THROW_IF(&*b!=p || a[0]!=1 || b[0]!=5, "cloned an unique object");
+
+    cvec c=a;
+    c[1]=7;
+    PROTON_THROW_IF(a[1]!=2 || c[1]!=7, "err");
+
+    cowref_<obj_cow> x(alloc, 3), y=x;
+    y->v=4;
+    PROTON_THROW_IF(x->v!=3 || y->v!=4 || cow_copies!=1, "err");
+    y->v=5;
+    PROTON_THROW_IF(cow_copies!=1, "err");
+
+    // an object seen by weak refs is cloned before writing, as unique() tells
+    typedef ref_<vector_<int>, smart_allocator<vector_<int> >, cow_traits<vector_<int> >, detail::wrefc_t> wcvec;
+    wcvec d(alloc);
+    d->push_back(1);
+    const wcvec& cd=d;
+    const vector_<int>* q=&*cd;
+    {
+        weak_<wcvec> w(d);
+        d[0]=9;
+        PROTON_THROW_IF(&*cd==q || cd[0]!=9, "written through a weakly shared object");
+    }
+    return 0;
+}
+
+int uref_ut()
+{
+    cout << "-> uref_ut" << endl;
+    PROTON_THROW_IF(sizeof(uref_<obj_num>)!=sizeof(void*), "err");
+    {
+        uref_<obj_num> a=make_uref<obj_num>(3);
+        PROTON_THROW_IF(a==none || a->v!=3 || (*a).v!=3, "err");
+        uref_<obj_num> b(std::move(a));
+        PROTON_THROW_IF(a!=none || b->v!=3, "err");
+        a=std::move(b);
+        PROTON_THROW_IF(a->v!=3 || b!=none, "err");
+
+        // down and up
+        uref_<obj_expr> e=make_uref<obj_neg>(2);
+        bool k=false;
+        try{
+            cast<uref_<obj_add> >(std::move(e));
+        }
+        catch(std::bad_cast&){
+            k=true;
+        }
+        PROTON_THROW_IF(!k || e==none, "err");
+        uref_<obj_num> n=cast<uref_<obj_num> >(std::move(e));
+        PROTON_THROW_IF(e!=none || n->v!=-2, "err");
+
+        // into a counted ref_, in place
+        const obj_num* p=&*n;
+        expr r=std::move(n);
+        PROTON_THROW_IF(n!=none || ref_count(r)!=1 || cast<num>(r)->v!=-2, "err");
+        PROTON_THROW_IF(&*cast<num>(r)!=p, "reallocated");
+        expr r2=r;
+        PROTON_THROW_IF(ref_count(r)!=2, "err");
+    }
+    {
+        uref_<vector_<int> > v(alloc, {1, 2, 3});
+        v[1]=5;
+        PROTON_THROW_IF(v[1]!=5 || v->size()!=3, "err");
+        uref_<vector_<int> > w(alloc, {1, 5, 3});
+        PROTON_THROW_IF(!(v==w) || w<v, "err");
+        ref_<vector_<int> > r=std::move(w);
+        PROTON_THROW_IF(*r!=*v, "err");
+
+        uref_<str> x(alloc, "abc");
+        std::ostringstream o;
+        o << x;
+        PROTON_THROW_IF(o.str()!="abc", "err");
+    }
+    return 0;
+}
+
+int node_count=0;
+
+struct obj_node;
+typedef cycref_<obj_node> node;
+
+struct obj_node{
+    int id;
+    vector_<node> out;
+    vector_<std::pair<int, node> > tagged;
+
+    obj_node(int i):id(i)
+    {
+        node_count++;
+    }
+
+    ~obj_node()
+    {
+        node_count--;
+    }
+
+    void trace(cc_visitor& v)const
+    {
+        v(id)(out)(tagged);
+    }
+};
+
+int cycle_ut()
+{
+    cout << "-> cycle_ut" << endl;
+    collect_cycles();
+    {
+        node a(alloc,1), b(alloc,2), c(alloc,3);
+        a->out.push_back(b);
+        b->out.push_back(c);
+        c->tagged.push_back(std::make_pair(0, a));
+        node s(alloc,4);
+        s->out.push_back(s);
+    }
+    PROTON_THROW_IF(node_count!=4, "err");
+    PROTON_THROW_IF(collect_cycles()!=4, "err");
+    PROTON_THROW_IF(node_count!=0 || cycle_roots()!=0, "err");
+
+    // alive cycles and acyclic graphs
+    {
+        node keep;
+        {
+            node a(alloc,1), b(alloc,2);
+            a->out.push_back(b);
+            b->out.push_back(a);
+            keep=b;
+        }
+        PROTON_THROW_IF(collect_cycles()!=0, "err");
+        PROTON_THROW_IF(node_count!=2, "freed alive objects");
+        PROTON_THROW_IF(keep->out[0]->out[0]->id!=2, "err");
+
+        node t(alloc,3);
+        t->out.push_back(node(alloc,4));
+        node u=t;
+        u=node();
+        PROTON_THROW_IF(collect_cycles()!=0, "err");
+        PROTON_THROW_IF(node_count!=4, "err");
+    }
+    PROTON_THROW_IF(collect_cycles()!=2 || node_count!=0, "err");
+
+    // a budget takes part of the roots
+    for(int i=0; i<10; i++){
+        node a(alloc,i), b(alloc,i);
+        a->out.push_back(b);
+        b->out.push_back(a);
+    }
+    PROTON_THROW_IF(node_count!=20, "err");
+    size_t n=collect_cycles(4);
+    PROTON_THROW_IF(n<4 || n>=20 || node_count!=(int)(20-n), "err");
+    PROTON_THROW_IF(collect_cycles()!=20-n || node_count!=0, "err");
+    PROTON_THROW_IF(cycle_roots()!=0, "err");
+    return 0;
+}
+
 int main()
 {
     proton::debug_level=1;
     proton::wait_on_err=0;
     std::vector<proton::detail::unittest_t> ut=
-        {ref_ut, ref_test_ut, reset_ut, cast_ut, stl_ut};
+        {ref_ut, ref_test_ut, reset_ut, cast_ut, stl_ut, move_op_ut, make_ref_ut, deferred_ut,
+         cycle_ut, type_tag_ut, hash_ut, cow_ut, uref_ut};
     return proton::detail::unittest_run(ut);
 }
 
@@ -0,0 +1,186 @@
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <cstdlib>
+#include <proton/base.hpp>
+#include <proton/string.hpp>
+#include <proton/rope.hpp>
+#include <proton/detail/unit_test.hpp>
+
+using namespace std;
+using namespace proton;
+
+// the height of an AVL tree is below 1.44*log2(leaves), and a leaf has a char at least
+static bool balanced(const rope& r)
+{
+    unsigned h=0;
+    for(size_t n=1; n<r.size()+2; n*=2)
+        h++;
+    return r.height()<=h*3/2+2;
+}
+
+static str random_text(size_t n)
+{
+    str s;
+    for(size_t i=0; i<n; i++)
+        s.push_back("abc xyz\n"[rand()%8]);
+    return s;
+}
+
+int edit_ut()
+{
+    cout << "-> edit_ut" << endl;
+    srand(1);
+    for(size_t round=0; round<20; round++){
+        rope r;
+        str s;
+        vector<rope> copies;
+        for(size_t i=0; i<300; i++){
+            long n=(long)s.size();
+            long a=rand()%(n+1)-(rand()%4 ? 0 : n); // negative offsets at times
+            long b=rand()%(n+1);
+            str t=random_text(rand()%4 ? rand()%20 : rand()%5000);
+            switch(rand()%6){
+            case 0:
+                r+=t;
+                s+=t;
+                break;
+            case 1:
+                r.insert(a, t);
+                s.insert(a<0 ? a+n : a, t);
+                break;
+            case 2:{
+                r.del(a, b);
+                long i=(a<0 ? a+n : a);
+                if(i<b)
+                    s.erase(i, b-i);
+                break;
+            }
+            case 3:
+                // concat with a slice of itself, sharing chunks
+                r+=r(a, b);
+                s+=s(a, b);
+                break;
+            case 4:
+                r.insert(b, r);
+                s.insert(b, s);
+                break;
+            default:
+                for(auto c: t){
+                    r.push_back(c);
+                    s.push_back(c);
+                }
+            }
+            if(s.size()>200000){
+                r=r(-1000);
+                s=s(-1000);
+            }
+            if(i%10==0)
+                copies.push_back(r); // shared chunks must not change
+            PROTON_THROW_IF(r.size()!=s.size() || r.str()!=s, "edit " << round << " " << i);
+            PROTON_THROW_IF(!balanced(r), "height " << r.height() << " of " << r.size());
+        }
+        for(auto& c: copies)
+            PROTON_THROW_IF(c.str().size()!=c.size(), "copies");
+    }
+    return 0;
+}
+
+int slice_ut()
+{
+    cout << "-> slice_ut" << endl;
+    str s=random_text(3000);
+    rope r(s);
+    PROTON_THROW_IF(r!=s || r.height()==0, "ctor");
+    long n=(long)s.size();
+    for(long i=-n-3; i<=n+3; i+=97){
+        PROTON_THROW_IF(r(i).str()!=s(i<-n ? 0 : i, n), "[i:] " << i);
+        for(long j=-n-3; j<=n+3; j+=89){
+            PROTON_THROW_IF(r(i,j).str()!=s(i,j), "[i:j] " << i << " " << j);
+            PROTON_THROW_IF(r(i,j,7).str()!=s(i,j,7), "[i:j:k] " << i << " " << j);
+        }
+    }
+    for(long i=-n; i<n; i+=13)
+        PROTON_THROW_IF(r[i]!=s[i], "[i] " << i);
+    bool thrown=false;
+    try{
+        r[n];
+    }
+    catch(proton::err&){
+        thrown=true;
+    }
+    PROTON_THROW_IF(!thrown, "out of range");
+
+    // iterators
+    PROTON_THROW_IF(str(r.begin(), r.end())!=s || r.end()-r.begin()!=n, "iterator");
+    PROTON_THROW_IF(*(r.begin()+2000)!=s[2000] || r.begin()[n-1]!=s[-1], "random access");
+    size_t k=0;
+    r.each_chunk([&](const str_view& v){
+        PROTON_THROW_IF(v!=s.view(k, k+v.size()), "chunk");
+        k+=v.size();
+    });
+    PROTON_THROW_IF(k!=s.size(), "chunks");
+
+    // repeat
+    rope x("ab");
+    PROTON_THROW_IF((x*0).size()!=0 || x*3!="ababab" || 2*x!="abab", "repeat");
+    rope big=r*1000;
+    PROTON_THROW_IF(big.size()!=s.size()*1000 || big(-n-5, -n+5).str()!=s(-5)+s(0,5) || !balanced(big), "big repeat");
+    return 0;
+}
+
+int str_ut()
+{
+    cout << "-> str_ut" << endl;
+    str s=random_text(5000);
+    rope r(s);
+    for(auto c: {'a', 'x', '\n', '#'}){
+        PROTON_THROW_IF(r.count(c)!=s.count(c), "count " << c);
+        for(size_t pos: {0, 1, 1500, 4999, 5000, 6000})
+            PROTON_THROW_IF(r.find(c, pos)!=s.find(c, pos), "find " << c << " " << pos);
+    }
+    for(size_t i=0; i<4900; i+=421){
+        str t=s.substr(i, 50);
+        PROTON_THROW_IF(r.find(t)!=s.find(t) || !r.startswith(s(0, i)) || !r.endswith(s(i)), "find " << i);
+        PROTON_THROW_IF(r.startswith(s(0,i)+"#") || r.endswith("#"+s(i)), "not startswith " << i);
+    }
+    PROTON_THROW_IF(r.find("#")!=rope::npos || r.find("", 10)!=10, "find npos");
+
+    rope w(str(" \t")*700+"  word one\n two  "+str("\n ")*900);
+    PROTON_THROW_IF(w.strip()!="word one\n two" || rope("  ").strip().size()!=0 || rope("a").strip()!="a", "strip");
+    PROTON_THROW_IF(rope("xxaxx").strip("x")!="a", "strip chars");
+    PROTON_THROW_IF(w.split()!=w.str().split() || r.split("\n")!=s.split("\n"), "split");
+
+    PROTON_THROW_IF(rope("a")<rope("a") || !(rope("a")<rope("ab")) || !(r(0,10)<r(0,10)+"z")
+                    || rope("b")<rope("ab") || rope("ab")!=str("ab") || "ab"!=rope("ab"), "compare");
+
+    // format into a rope
+    rope f(s);
+    f.format("[%s=%d]", _t("key", 42));
+    PROTON_THROW_IF(f.size()!=s.size()+8 || !f.endswith("[key=42]") || !f.startswith(s), "format");
+    PROTON_THROW_IF(rope("%s-%x") % _t(r(0,3), 255)!=s(0,3)+"-ff", "%");
+    rope g;
+    g.format("%s", str(3000, 'y'));
+    PROTON_THROW_IF(g!=str(3000, 'y'), "long format");
+
+    ostringstream o;
+    o << r;
+    PROTON_THROW_IF(o.str()!=s.c_str(), "output");
+    std::string x=r;
+    PROTON_THROW_IF(x!=s.c_str(), "std::string");
+
+    wrope wr(L"wide ");
+    wr+=wr;
+    PROTON_THROW_IF(wr.str()!=L"wide wide " || wr.strip()!=L"wide wide", "wide");
+    return 0;
+}
+
+int main()
+{
+    proton::debug_level=1;
+    proton::wait_on_err=0;
+    std::vector<proton::detail::unittest_t> ut=
+        {edit_ut, slice_ut, str_ut};
+    return proton::detail::unittest_run(ut);
+}
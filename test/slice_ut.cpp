@@ -0,0 +1,159 @@
+#include <iostream>
+#include <sstream>
+#include <vector>
+#include <string>
+#include <proton/base.hpp>
+#include <proton/vector.hpp>
+#include <proton/deque.hpp>
+#include <proton/string.hpp>
+#include <proton/slice.hpp>
+#include <proton/detail/unit_test.hpp>
+
+using namespace std;
+using namespace proton;
+
+template<typename F>
+bool throws(F f)
+{
+    try{
+        f();
+    }
+    catch(proton::err&){
+        return true;
+    }
+    return false;
+}
+
+// view(i,j,k) has the items of operator()(i,j,k), for all offsets near the ends
+template<typename C>
+int check_views(const C& x)
+{
+    long n=(long)x.size();
+    for(long i=-n-2; i<=n+2; i++){
+        if(throws([&](){ x(i); })){
+            PROTON_THROW_IF(!throws([&](){ x.view(i); }), "view " << i << " in range");
+        }
+        else{
+            PROTON_THROW_IF(x.view(i)!=x(i), "view " << i);
+        }
+        for(long j=-n-2; j<=n+2; j++){
+            PROTON_THROW_IF(x.view(i,j)!=x(i,j), "view " << i << " " << j);
+            for(size_t k=1; k<=4; k++){
+                auto v=x.view(i,j,k);
+                auto r=x(i,j,k);
+                PROTON_THROW_IF(v!=r || r!=v || v.size()!=r.size() || v.step()!=k,
+                                "view " << i << " " << j << " " << k);
+                PROTON_THROW_IF(v.template to<C>()!=r, "to " << i << " " << j << " " << k);
+                if(!r.empty())
+                    PROTON_THROW_IF(v[-1]!=r[-1] || v.front()!=r[0] || v.back()!=r[-1], "index");
+            }
+        }
+    }
+    return 0;
+}
+
+int vector_ut()
+{
+    cout << "-> vector_ut" << endl;
+    vector_<int> x;
+    for(int i=0; i<10; i++){
+        check_views(x);
+        x.append(i);
+    }
+    check_views(x);
+
+    // the items are the ones of x
+    const vector_<int>& c=x;
+    auto v=c.view(1,-1,3);
+    PROTON_THROW_IF(&v[0]!=&x[1] || &v[1]!=&x[4] || &v[2]!=&x[7], "no copy");
+    PROTON_THROW_IF(v.size()!=3 || v!=vector_<int>({1,4,7}), "items");
+
+    // slices of slices
+    auto w=x.view(0,10,2);
+    PROTON_THROW_IF(w(1)!=vector_<int>({2,4,6,8}) || w(1,-1,2)!=vector_<int>({2,6}) || w(-2)!=vector_<int>({6,8}),
+                    "nested");
+    PROTON_THROW_IF(w(3,1).size()!=0 || w(0,100,100).size()!=1, "nested empty");
+
+    // writable views
+    for(auto& i: x.view(0,-1,2))
+        i=-i;
+    PROTON_THROW_IF(x!=vector_<int>({0,1,-2,3,-4,5,-6,7,-8,9}), "write");
+    x.view(-1)[0]=90;
+    PROTON_THROW_IF(x[-1]!=90, "write last");
+
+    // random access
+    auto s=x.view(1,10,2);
+    PROTON_THROW_IF(s.end()-s.begin()!=5 || *(s.begin()+2)!=5 || s.begin()[4]!=90
+                    || *std::max_element(s.begin(), s.end())!=90, "iterator");
+    vector_<int> r(s.begin(), s.end());
+    std::sort(r.begin(), r.end());
+    PROTON_THROW_IF(r!=vector_<int>({1,3,5,7,90}), "sort");
+
+    ostringstream o;
+    o << c.view(0,4);
+    PROTON_THROW_IF(o.str()!="[0, 1, -2, 3]", "output " << o.str());
+
+    // slices of const and writable iterators
+    PROTON_THROW_IF(x.view(0,4,2)!=c.view(0,4,2) || !(c.view(0,4,2)==x.view(0,4,2)) || x.view(0,4,2)==c.view(1,5,2),
+                    "mixed iterators");
+
+    PROTON_THROW_IF(!throws([&](){ x.view(0,1,0); }), "zero step");
+    PROTON_THROW_IF(!throws([&](){ c.view(0,3)[3]; }), "out of range");
+    PROTON_THROW_IF(!throws([&](){ x.view(10); }) || !throws([&](){ c.view(-11); }), "view(i) out of range");
+    return 0;
+}
+
+int deque_ut()
+{
+    cout << "-> deque_ut" << endl;
+    deque_<str> x;
+    for(int i=0; i<10; i++){
+        check_views(x);
+        x.append(to_<str>(i));
+    }
+    check_views(x);
+    auto v=x.view(-3);
+    PROTON_THROW_IF(&v[0]!=&x[7] || v!=vector_<str>({"7","8","9"}), "no copy");
+    return 0;
+}
+
+int str_ut()
+{
+    cout << "-> str_ut" << endl;
+    str x;
+    for(int i=0; i<10; i++){
+        check_views(x);
+        x.push_back('a'+i);
+    }
+    check_views(x);
+    str_view v=x.view(2,-2);
+    PROTON_THROW_IF(v!="cdefgh" || v.data()!=x.data()+2 || x.view(-3)!="hij", "view");
+    auto s=x.view(0,10,3);
+    PROTON_THROW_IF(s!="adgj" || "adgj"!=s || s.to<str>()!="adgj" || s(1,-1)!="dg", "step");
+    PROTON_THROW_IF(s==str_view("adg") || s!=str_view("adgj") || s=="adgjx", "compare");
+    const char* p="adgj";
+    PROTON_THROW_IF(s!=p || p!=s || str("abcdef").view(0,6,2)!="ace", "C string");
+    wstr w=L"wide";
+    PROTON_THROW_IF(w.view(0,4,2)!=L"wd", "wide");
+    return 0;
+}
+
+int free_ut()
+{
+    cout << "-> free_ut" << endl;
+    std::vector<int> x={0,1,2,3,4,5};
+    PROTON_THROW_IF(view(x,1)!=std::vector<int>({1,2,3,4,5}) || view(x,-4,-1,2)!=std::vector<int>({2,4}), "vector");
+    PROTON_THROW_IF(view(x,3,1).size()!=0 || view(x,-10,10,5).to<std::vector<int> >()!=std::vector<int>({0,5}), "clamp");
+    std::string s="hello world";
+    PROTON_THROW_IF(view(s,0,-1,2).to<std::string>()!="hlowr", "string");
+    return 0;
+}
+
+int main()
+{
+    proton::debug_level=1;
+    proton::wait_on_err=0;
+    std::vector<proton::detail::unittest_t> ut=
+        {vector_ut, deque_ut, str_ut, free_ut};
+    return proton::detail::unittest_run(ut);
+}
@@ -0,0 +1,284 @@
+// microbenchmark of the char scanning behind split(), split_view(), tokenize(), strip(), count() and index(),
+// and of join(), small_str fields, %, case conversion, number conversions, rope edits and hashes.
+// build: make str_bench
+// usage: str_bench [lines]
+
+#include <iostream>
+#include <chrono>
+#include <cstdlib>
+#include <proton/base.hpp>
+#include <proton/string.hpp>
+#include <proton/small_string.hpp>
+#include <proton/rope.hpp>
+#include <proton/unordered_map.hpp>
+#include <proton/detail/scan.hpp>
+#include <boost/algorithm/string/case_conv.hpp>
+
+using namespace std;
+using namespace proton;
+using namespace proton::detail;
+
+// split by find_first_of(), as str::split() did before the scan kernels
+deque_<str> split_old(const str& s, const str& spc)
+{
+    deque_<str> r;
+    long pos=0, begin, end;
+    do{
+        begin=s.find_first_not_of(spc, pos);
+        if(begin<0)
+            break;
+        end=s.find_first_of(spc, begin);
+        if(end<0)
+            end=s.length();
+        r.push_back(s.substr(begin, end-begin));
+        pos=end;
+    }
+    while(pos<(long)s.length());
+    return r;
+}
+
+str strip_old(const str& s, const str& spc)
+{
+    long i=s.find_first_not_of(spc);
+    long j=s.find_last_not_of(spc);
+    if(i<0 || j<0 || j<i)
+        return "";
+    return s.substr(i, j-i+1);
+}
+
+// join by +=, as join() did before pre-sizing
+template<typename string_list>
+str join_old(const char* token, const string_list& r)
+{
+    if(r.empty())
+        return "";
+    auto it=r.begin();
+    str res=*it;
+    for(++it; it!=r.end(); ++it)
+        res+=token+*it;
+    return res;
+}
+
+// % by streams, as the format engine did before
+void old_prefix(std::ostream& o, const char*& f)
+{
+    while(f){
+        const char* p=strchr(f, '%');
+        if(!p){
+            o << f;
+            f=NULL;
+        }
+        else if(p[1]=='%'){
+            o.write(f, p-f+1);
+            f=p+2;
+        }
+        else{
+            o.write(f, p-f);
+            f=p+1;
+            return;
+        }
+    }
+}
+
+void format_old_args(std::ostream& o, const char*& f)
+{
+}
+
+template<typename V, typename ...R>
+void format_old_args(std::ostream& o, const char*& f, const V& v, const R& ...r)
+{
+    old_prefix(o, f);
+    switch(*f){
+        case 'x': o << std::hex << std::nouppercase << v; break;
+        default: o << std::dec << v;
+    }
+    f++;
+    format_old_args(o, f, r...);
+}
+
+template<typename ...V>
+str format_old(const char* f, const V& ...v)
+{
+    std::basic_ostringstream<char, std::char_traits<char>, smart_allocator<char> > o;
+    format_old_args(o, f, v...);
+    old_prefix(o, f);
+    return o.str();
+}
+
+// to_lower() by tolower(), as it was before
+str to_lower_old(const str& s)
+{
+    str r(s);
+    for(auto& c: r)
+        c=tolower(c);
+    return r;
+}
+
+// to_() and get_int() by streams, as they were before
+str to_old(long n, int base)
+{
+    std::basic_ostringstream<char, std::char_traits<char>, smart_allocator<char> > s;
+    set_base(s, base, true);
+    s << n;
+    return s.str();
+}
+
+bool get_int_old(long& r, const str& s, int base)
+{
+    bool is_hex= (base==16);
+    str v1;
+    if( iendswith(s,"h") ){
+        v1=s.substr(0,s.length()-1);
+        is_hex=true;
+    }
+    else if( istartswith(s,"0x") ){
+        v1=s;
+        is_hex=true;
+    }
+    else{
+        v1=s;
+    }
+    std::basic_istringstream<char, std::char_traits<char>, smart_allocator<char> > i(v1);
+    long x;
+    if(is_hex)
+        i >> std::hex;
+    if ( (!(i >> x)) || (i.get()>0) ){
+        return false;
+    }
+    r=x;
+    return true;
+}
+
+template<typename F>
+double run(const char* name, F f)
+{
+    auto t0=std::chrono::steady_clock::now();
+    size_t n=f();
+    double ms=std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now()-t0).count();
+    cout << "  " << name << ": " << ms << " ms (" << n << ")" << endl;
+    return ms;
+}
+
+int main(int argc, char** argv)
+{
+    size_t lines=(argc>1 ? atol(argv[1]) : 200000);
+    const char* words[]={"GET", "/index.html", "HTTP/1.1", "200", "1024", "-", "\"Mozilla/5.0\"",
+                         "192.168.0.1", "[10/Oct/2000:13:55:36", "-0700]", "some_long_request_parameter"};
+    deque_<str> data;
+    for(size_t i=0; i<lines; i++){
+        str s="    ";
+        for(int k=0; k<12; k++){
+            s+=words[rand()%11];
+            s+=(rand()%4 ? " " : "\t  ");
+        }
+        data.push_back(s);
+    }
+    str ws=" \t\r\n";
+
+    cout << "old split (find_first_of):" << endl;
+    run("split", [&](){ size_t n=0; for(auto& s: data) n+=split_old(s, ws).size(); return n; });
+    run("strip", [&](){ size_t n=0; for(auto& s: data) n+=strip_old(s, ws).size(); return n; });
+    run("count", [&](){ size_t n=0; for(auto& s: data) n+=std::count(s.begin(), s.end(), ' '); return n; });
+
+    deque_<deque_<str> > rows;
+    for(auto& s: data)
+        rows.push_back(s.split());
+    cout << "join:" << endl;
+    run("old join", [&](){ size_t n=0; for(auto& r: rows) n+=join_old("\t", r).size(); return n; });
+    run("join", [&](){ size_t n=0; for(auto& r: rows) n+=join("\t", r).size(); return n; });
+    run("str::join", [&](){ size_t n=0; str t("\t"); for(auto& r: rows) n+=t.join(r).size(); return n; });
+
+    cout << "fields:" << endl;
+    run("str", [&](){ size_t n=0; vector_<str> v; for(auto& s: data){ split(v, s, ws); n+=v.size(); } return n; });
+    run("small_str", [&](){ size_t n=0; vector_<small_str> v; for(auto& s: data){ split(v, s, ws); n+=v.size(); } return n; });
+    const char* key="192.168.100.200:8080"; // beyond the inline buffer of str, not of small_str
+    run("str keys", [&](){ size_t n=0; for(size_t i=0; i<lines*10; i++){ str k(key); n+=k.size(); } return n; });
+    run("small_str keys", [&](){ size_t n=0; for(size_t i=0; i<lines*10; i++){ small_str k(key); n+=k.size(); } return n; });
+
+    cout << "format:" << endl;
+    const char* fmt="%s %d [%s] \"%s\" id=%x t=%f %d%%";
+    run("old %", [&](){ size_t n=0; for(size_t i=0; i<lines; i++){
+        n+=format_old(fmt, data[i].size(), i, words[i%11], data[i], i*7, i*0.25, 50).size(); } return n; });
+    run("%", [&](){ size_t n=0; for(size_t i=0; i<lines; i++){
+        n+=(fmt % _t(data[i].size(), i, words[i%11], data[i], i*7, i*0.25, 50)).size(); } return n; });
+    run("old % ints", [&](){ size_t n=0; for(size_t i=0; i<lines; i++){
+        n+=format_old("%d,%d,%d,%x", i, i*3, -(long)i, i).size(); } return n; });
+    run("% ints", [&](){ size_t n=0; for(size_t i=0; i<lines; i++){
+        n+=("%d,%d,%d,%x" % _t(i, i*3, -(long)i, i)).size(); } return n; });
+
+    cout << "case:" << endl;
+    run("old to_lower", [&](){ size_t n=0; for(auto& s: data) n+=to_lower_old(s).size(); return n; });
+    run("to_lower", [&](){ size_t n=0; for(auto& s: data) n+=to_lower(s).size(); return n; });
+    run("old upper", [&](){ size_t n=0; for(auto& s: data) n+=str(boost::algorithm::to_upper_copy(s)).size(); return n; });
+    run("upper", [&](){ size_t n=0; for(auto& s: data) n+=s.upper().size(); return n; });
+    deque_<str> uppers;
+    for(auto& s: data)
+        uppers.push_back(s.upper());
+    run("old iequals", [&](){ size_t n=0; for(size_t i=0; i<lines; i++) n+=boost::algorithm::iequals(data[i], uppers[i]); return n; });
+    run("iequals", [&](){ size_t n=0; for(size_t i=0; i<lines; i++) n+=iequals(data[i], uppers[i]); return n; });
+    run("old istartswith", [&](){ size_t n=0; for(size_t i=0; i<lines; i++){
+        n+=boost::algorithm::istarts_with(data[i], "    get /INDEX.html"); } return n; });
+    run("istartswith", [&](){ size_t n=0; for(size_t i=0; i<lines; i++) n+=istartswith(data[i], "    get /INDEX.html"); return n; });
+
+    cout << "numbers:" << endl;
+    vector_<str> nums, hexes;
+    for(size_t i=0; i<lines; i++){
+        nums.push_back(to_<str>((long)(i*7919)-(long)lines));
+        hexes.push_back(to_<str>((long)i*7919, 16));
+    }
+    run("old to_", [&](){ size_t n=0; for(size_t i=0; i<lines; i++) n+=to_old(i*7919, 10).size()+to_old(i, 16).size(); return n; });
+    run("to_", [&](){ size_t n=0; for(size_t i=0; i<lines; i++) n+=to_<str>(i*7919).size()+to_<str>(i, 16).size(); return n; });
+    run("old to_ double", [&](){ size_t n=0; for(size_t i=0; i<lines; i++){
+        std::basic_ostringstream<char, std::char_traits<char>, smart_allocator<char> > o; o << i*0.37; n+=o.str().size(); } return n; });
+    run("to_ double", [&](){ size_t n=0; for(size_t i=0; i<lines; i++) n+=to_<str>(i*0.37).size(); return n; });
+    run("old get_int", [&](){ long n=0, x; for(size_t i=0; i<lines; i++){
+        get_int_old(x, nums[i], 10); n+=x; get_int_old(x, hexes[i], 10); n+=x; } return (size_t)n; });
+    run("get_int", [&](){ long n=0, x; for(size_t i=0; i<lines; i++){
+        get_int(x, nums[i]); n+=x; get_int(x, hexes[i]); n+=x; } return (size_t)n; });
+    run("get_float", [&](){ double n=0, x; for(size_t i=0; i<lines; i++){ if(get_float(x, nums[i])) n+=x; } return (size_t)n; });
+
+    // a document of all lines, edited in the middle
+    cout << "rope:" << endl;
+    str doc=join("\n", data);
+    size_t edits=lines/100;
+    run("str insert", [&](){ str d=doc; for(size_t i=0; i<edits; i++) d.insert(d.size()/2, data[i]); return d.size(); });
+    run("rope insert", [&](){ rope d(doc); for(size_t i=0; i<edits; i++) d.insert(d.size()/2, data[i]); return d.size(); });
+    size_t splices=edits/50+1; // each copies the whole str
+    run("str splice", [&](){ str d=doc; for(size_t i=0; i<splices; i++){
+        size_t k=d.size()/3; d=d(k, 2*k)+d(0, k)+d(2*k); } return d.size(); });
+    run("rope splice", [&](){ rope d(doc); for(size_t i=0; i<splices; i++){
+        long k=d.size()/3; d=d(k, 2*k)+d(0, k)+d(2*k); } return d.size(); });
+    run("str append", [&](){ str d; for(size_t i=0; i<lines; i++) d+=data[i]; return d.size(); });
+    run("rope append", [&](){ rope d; for(size_t i=0; i<lines; i++) d+=data[i]; return d.size(); });
+
+    // old rows: the libstdc++ hash of std::string (murmur2), as std::hash of str was before hash.hpp
+    cout << "hash:" << endl;
+    vector_<str_view> fields, v;
+    for(auto& s: data){
+        s.tokenize(v);
+        fields.extend(v);
+    }
+#ifdef __GLIBCXX__
+    run("old lines", [&](){ size_t n=0; for(auto& s: data) n+=std::_Hash_impl::hash(s.data(), s.size()); return n; });
+#endif
+    run("lines", [&](){ size_t n=0; for(auto& s: data) n+=std::hash<str>()(s); return n; });
+#ifdef __GLIBCXX__
+    run("old fields", [&](){ size_t n=0; for(auto& s: fields) n+=std::_Hash_impl::hash(s.data(), s.size()); return n; });
+#endif
+    run("fields", [&](){ size_t n=0; for(auto& s: fields) n+=std::hash<str_view>()(s); return n; });
+    run("tuple keys", [&](){ unordered_map_<std::tuple<str, int>, int> m;
+        for(size_t i=0; i+1<fields.size(); i+=3){ m[_t(str(fields[i]), (int)fields[i+1].size())]++; } return m.size(); });
+
+    const char* names[]={"scalar", "sse2", "sse4.2", "avx2"};
+    int best=scan_level();
+    for(int level=scan_scalar; level<=best; level++){
+        set_scan_level(level);
+        cout << "scan kernels, " << names[level] << ":" << endl;
+        run("split", [&](){ size_t n=0; for(auto& s: data) n+=s.split().size(); return n; });
+        run("split_view", [&](){ size_t n=0; for(auto& s: data) n+=s.split_view().size(); return n; });
+        run("tokenize", [&](){ size_t n=0; vector_<str_view> v; for(auto& s: data) n+=s.tokenize(v); return n; });
+        run("strip", [&](){ size_t n=0; for(auto& s: data) n+=s.strip().size(); return n; });
+        run("count", [&](){ size_t n=0; for(auto& s: data) n+=s.count(' '); return n; });
+    }
+    return 0;
+}
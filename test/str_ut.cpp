@@ -0,0 +1,469 @@
+#include <iostream>
+#include <cstdlib>
+#include <string>
+#include <vector>
+#include <sstream>
+#include <proton/base.hpp>
+#include <proton/string.hpp>
+#include <proton/small_string.hpp>
+#include <proton/vector.hpp>
+#include <proton/tuple.hpp>
+#include <proton/detail/scan.hpp>
+#include <proton/detail/unit_test.hpp>
+
+using namespace std;
+using namespace proton;
+using namespace proton::detail;
+
+// the old split, by find_first_of()
+deque_<str> split_ref(const str& s, const str& spc, int null_unite)
+{
+    deque_<str> r;
+    long pos=0, begin, end;
+    if(null_unite){
+        do{
+            begin=s.find_first_not_of(spc, pos);
+            if(begin<0)
+                break;
+            end=s.find_first_of(spc, begin);
+            if(end<0)
+                end=s.length();
+            r.push_back(s.substr(begin, end-begin));
+            pos=end;
+        }
+        while(pos<(long)s.length());
+    }
+    else{
+        while(1){
+            begin=s.find_first_of(spc, pos);
+            if(begin<0){
+                r.push_back(s.substr(pos));
+                break;
+            }
+            r.push_back(s.substr(pos, begin-pos));
+            pos=begin+1;
+            if(pos>=(long)s.length()){
+                r.push_back("");
+                break;
+            }
+        }
+    }
+    return r;
+}
+
+str random_str(size_t n, const char* alphabet)
+{
+    size_t k=strlen(alphabet);
+    str s;
+    for(size_t i=0; i<n; i++)
+        s.push_back(alphabet[rand()%k]);
+    return s;
+}
+
+int kernel_ut()
+{
+    cout << "-> kernel_ut" << endl;
+    const char* sets[]={" ", " \t\r\n", ",;:|/\\-=", "abcdefghijkl", "abcdefghijklmnopqrs", "\x80\xff"};
+    int best=scan_level();
+    for(int level=scan_scalar; level<=best; level++){
+        PROTON_THROW_IF(set_scan_level(level)!=level, "err");
+        for(auto spc: sets){
+            char_set cs(spc, strlen(spc));
+            for(size_t n=0; n<100; n++){
+                str s=random_str(n, " \t\r\n,;:|/\\-=abcdefghijklmnopqrstuvwxyz\x80\xff");
+                const char* b=s.data();
+                const char* e=b+s.size();
+                // all windows near the ends, to cover heads and tails of vectors
+                for(size_t i=0; i<=n && i<40; i++){
+                    size_t p=s.find_first_of(spc, i);
+                    PROTON_THROW_IF(scan_first_of(b+i, e, cs)!=(p==str::npos ? e : b+p),
+                                    "first_of " << level << " " << spc << " " << i);
+                    p=s.find_first_not_of(spc, i);
+                    PROTON_THROW_IF(scan_first_not_of(b+i, e, cs)!=(p==str::npos ? e : b+p),
+                                    "first_not_of " << level);
+                    str t=s.substr(0, n-i);
+                    p=t.find_last_not_of(spc);
+                    PROTON_THROW_IF(scan_last_not_of(b, e-i, cs)!=(p==str::npos ? NULL : b+p),
+                                    "last_not_of " << level);
+                    PROTON_THROW_IF(scan_count(b+i, e, 'a')!=(size_t)std::count(b+i, e, 'a'),
+                                    "count " << level);
+                    // split at i, the sums are the non-empty items of isplit()
+                    size_t k=scan_count_tokens(b, b+i, cs, true)
+                             +scan_count_tokens(b+i, e, cs, i==0 || cs.has(b[i-1]));
+                    size_t items=0;
+                    for(auto x: s.isplit(spc))
+                        items+=!x.empty();
+                    PROTON_THROW_IF(k!=items,
+                                    "count_tokens " << level << " " << spc << " " << i);
+                }
+            }
+        }
+    }
+    // long runs for 8-bit counters
+    str s(100000, 'x');
+    PROTON_THROW_IF(scan_count(s.data(), s.data()+s.size(), 'x')!=100000, "err");
+    set_scan_level(best);
+    PROTON_THROW_IF(scan_level()!=best, "err");
+    return 0;
+}
+
+int case_ut()
+{
+    cout << "-> case_ut" << endl;
+    const char* chars="azAZ@[`{09 _-\x80\xc3\xa9\xff";
+    int best=scan_level();
+    for(int level=scan_scalar; level<=best; level++){
+        set_scan_level(level);
+        for(size_t n=0; n<100; n++){
+            str s=random_str(n, n%3 ? "abcxyzABCXYZ@[`{09 _-" : chars);
+            str lo=s, up=s;
+            for(auto& c: lo)
+                c=std::tolower(c, std::locale());
+            for(auto& c: up)
+                c=std::toupper(c, std::locale());
+            PROTON_THROW_IF(to_lower(s)!=lo || s.upper()!=up || s.lower()!=lo, "case " << level << " " << s);
+            str t=s;
+            PROTON_THROW_IF(to_upper_inplace(t)!=up || t!=up, "in place " << level);
+            std::string x(s);
+            PROTON_THROW_IF(to_lower(x)!=lo.c_str(), "std::string " << level);
+            for(size_t i=0; i<=n; i++){
+                str a=s.substr(i), b=up.substr(i);
+                PROTON_THROW_IF(!iequals(a, b) || !istartswith(s, lo.substr(0, i)) || !iendswith(up, a),
+                                "iequals " << level << " " << s << " " << i);
+                if(i<n){
+                    // a different char at i, differing in case or not
+                    str c=lo;
+                    c[i]=(c[i]=='a' ? 'B' : 'a');
+                    PROTON_THROW_IF(iequals(s, c) || istartswith(s, c.substr(0, i+1)) || iendswith(s, c.substr(i)),
+                                    "not iequals " << level << " " << s << " " << i);
+                }
+            }
+        }
+    }
+    set_scan_level(best);
+    PROTON_THROW_IF(!istartswith("abcdef", "ABc") || istartswith("ab", "abc") || !iendswith(str("x.TXT"), ".txt")
+                    || !iequals(str_view("Key"), "KEY") || iequals("key", "keys"), "views");
+    PROTON_THROW_IF(wstr(L"AbC").lower()!=L"abc" || !istartswith(wstr(L"AbC"), L"aB") || !iequals(wstr(L"x"), L"X"), "wide");
+    return 0;
+}
+
+int split_ut()
+{
+    cout << "-> split_ut" << endl;
+    const char* spcs[]={"", ",", " \t", ",;:|/\\-=abcd"};
+    for(size_t n=0; n<200; n++){
+        str s=random_str(n, "  \t,;abcdefghijklmnopqrstuvwxyz");
+        for(auto spc: spcs){
+            for(int u=-1; u<=1; u++){
+                str set=(*spc ? spc : " \t\r\n");
+                int nu=(u>=0 ? u : (*spc ? 0 : 1));
+                PROTON_THROW_IF(s.split(spc, u)!=split_ref(s, set, nu), "split '" << s << "'");
+                deque_<str> r;
+                split(r, s, str(spc), u);
+                PROTON_THROW_IF(r!=split_ref(s, set, nu), "free split '" << s << "'");
+            }
+        }
+        std::string x(s.c_str());
+        size_t i=x.find_first_not_of(" \t\r\n"), j=x.find_last_not_of(" \t\r\n");
+        str t=(i==std::string::npos ? "" : x.substr(i, j-i+1).c_str());
+        PROTON_THROW_IF(s.strip()!=t || strip(s)!=t || strip(x)!=t.c_str(), "strip '" << s << "'");
+        PROTON_THROW_IF(s.count('a')!=(size_t)std::count(x.begin(), x.end(), 'a'), "err");
+    }
+    str s("abc,def");
+    PROTON_THROW_IF(s.index(',')!=3 || s.strip("ac")!="bc,def", "err");
+    wstr w(L" a b ");
+    PROTON_THROW_IF(w.split().size()!=2 || w.strip()!=L"a b" || w.count(L' ')!=3, "err");
+    return 0;
+}
+
+int view_ut()
+{
+    cout << "-> view_ut" << endl;
+    const char* spcs[]={"", ",", " \t"};
+    vector_<str_view> v;
+    for(size_t n=0; n<200; n++){
+        str s=random_str(n, "  \t,;abcdefghijklmnopqrstuvwxyz");
+        for(auto spc: spcs){
+            for(int u=-1; u<=1; u++){
+                deque_<str> r=s.split(spc, u);
+                vector_<str_view> w=s.split_view(spc, u);
+                PROTON_THROW_IF(s.tokenize(v, spc, u)!=r.size() || w.size()!=r.size(), "size '" << s << "'");
+                for(size_t i=0; i<r.size(); i++){
+                    PROTON_THROW_IF(v[i]!=r[i] || w[i]!=r[i], "view '" << s << "'");
+                    PROTON_THROW_IF(v[i].data()<s.data() || v[i].end()>s.data()+s.size(), "not a view");
+                }
+                vector_<str_view> f;
+                split(f, s, str(spc), u);
+                PROTON_THROW_IF(f!=v, "free split '" << s << "'");
+            }
+        }
+    }
+    // no reallocation once the list is big enough
+    str line("a b c d e f g h");
+    line.tokenize(v);
+    const str_view* p=v.data();
+    for(int i=0; i<10; i++)
+        PROTON_THROW_IF(line.tokenize(v)!=8 || v.data()!=p, "realloc");
+
+    str_view x("hello world");
+    str h=x.substr(6);
+    std::string sh=x.substr(0, 5);
+    PROTON_THROW_IF(h!="world" || sh!="hello" || x.find('o')!=4 || x.find('o', 5)!=7 || x.find('z')!=str_view::npos, "err");
+    PROTON_THROW_IF(!(x.substr(0,5)<h) || x=="hello" || x.substr(0,5)!="hello" || len(x)!=11, "err");
+    PROTON_THROW_IF(std::hash<str_view>()(h)!=std::hash<str>()(h), "hash");
+    std::ostringstream o;
+    o << "[" << std::setw(7) << x.substr(6) << "][" << std::left << std::setw(6) << x.substr(0,5) << "]";
+    PROTON_THROW_IF(o.str()!="[  world][hello ]", o.str());
+    wstr ws(L"a,b");
+    PROTON_THROW_IF(ws.split_view(L",").size()!=2 || ws.split_view(L",")[1]!=L"b", "err");
+    return 0;
+}
+
+int lazy_ut()
+{
+    cout << "-> lazy_ut" << endl;
+    const char* spcs[]={"", ",", " \t"};
+    for(size_t n=0; n<200; n++){
+        str s=random_str(n, "  \t,;abcdefghijklmnopqrstuvwxyz");
+        for(auto spc: spcs){
+            for(int u=-1; u<=1; u++){
+                deque_<str> r=s.split(spc, u);
+                vector_<str> v;
+                v.extend(s.isplit(spc, u));
+                PROTON_THROW_IF(!std::equal(r.begin(), r.end(), v.begin()) || v.size()!=r.size() || len(s.isplit(spc, u))!=r.size(), "isplit '" << s << "'");
+                PROTON_THROW_IF(s.isplit(spc, u).empty()!=r.empty(), "empty");
+                std::istringstream in(s.c_str());
+                deque_<str> w;
+                for(auto& f: isplit(in, spc, u))
+                    w.push_back(f);
+                PROTON_THROW_IF(w!=r, "stream isplit '" << s << "' " << spc << u);
+                PROTON_THROW_IF(str(spc).join(s.isplit(spc, u))!=str(spc).join(r), "join");
+            }
+        }
+        PROTON_THROW_IF(str(",").join(isplit(s, ","))!=s, "join '" << s << "'");
+    }
+    // early exit
+    str s("a b c d");
+    int n=0;
+    for(auto& f: s.isplit()){
+        n++;
+        if(f=="b")
+            break;
+    }
+    PROTON_THROW_IF(n!=2, "err");
+    std::istringstream in("x,y,z");
+    auto r=isplit(in, ",");
+    auto it=r.begin();
+    PROTON_THROW_IF(*it!="x" || *++it!="y" || in.eof(), "err");
+    std::vector<const char*> cs={"ab", "", "c"};
+    PROTON_THROW_IF(str("--").join(cs)!="ab----c" || str("-").join(vector_<str>())!="", "err");
+    wstr w(L"a b");
+    PROTON_THROW_IF(len(w.isplit())!=2 || wstr(L"+").join(w.isplit())!=L"a+b", "err");
+    return 0;
+}
+
+int join_ut()
+{
+    cout << "-> join_ut" << endl;
+    for(size_t n=0; n<100; n++){
+        str s=random_str(n, ",abc");
+        deque_<str> d=s.split(",");
+        vector_<str> v(d.begin(), d.end());
+        std::vector<std::string> l;
+        for(auto& x: d)
+            l.push_back(x.c_str());
+        PROTON_THROW_IF(join(",", d)!=s || join(",", v)!=s || join(",", l)!=s.c_str(), "join '" << s << "'");
+        PROTON_THROW_IF(join(",", s.split_view(","))!=s || join(",", s.isplit(","))!=s, "join views '" << s << "'");
+        PROTON_THROW_IF(str(",").join(v)!=s || str(",").join(s.split_view(","))!=s, "err");
+        str r=join("::", v);
+        PROTON_THROW_IF(r.size()!=s.size()+s.count(','), "err");
+    }
+    std::vector<const char*> cs={"a", "b"};
+    PROTON_THROW_IF(join("+", cs)!="a+b" || join("+", vector_<str>())!="", "err");
+    str a("ab");
+    a+=str_view("cde").substr(1);
+    PROTON_THROW_IF(a!="abde" || a+str_view("f")!="abdef", "err");
+    return 0;
+}
+
+int small_str_ut()
+{
+    cout << "-> small_str_ut" << endl;
+    PROTON_THROW_IF(small_str::inline_capacity!=23, "err");
+    small_str a("a short token");
+    PROTON_THROW_IF(a.capacity()!=23 || a.data()<(char*)&a || a.data()>=(char*)(&a+1), "not inline");
+    small_str b(a);
+    b+=" grows to the heap";
+    PROTON_THROW_IF(b!="a short token grows to the heap" || a!="a short token", "err");
+    PROTON_THROW_IF(b.capacity()<b.size() || (b.data()>=(char*)&b && b.data()<(char*)(&b+1)), "not on heap");
+    // growing within the size class of the chunk keeps the buffer
+    const char* p=b.data();
+    while(b.size()<b.capacity())
+        b.push_back('!');
+    PROTON_THROW_IF(b.data()!=p, "realloc in capacity");
+    b.append(b.data(), 5);
+    PROTON_THROW_IF(b.substr(b.size()-5)!="a sho", "self append");
+    p=b.data();
+    small_str c(std::move(b)), d;
+    PROTON_THROW_IF(c.data()!=p || !b.empty() || b.capacity()!=23, "move");
+    d=std::move(a);
+    PROTON_THROW_IF(d!="a short token" || !a.empty() || d.c_str()[d.size()]!=0, "err");
+    str s=d;
+    std::string t=d;
+    PROTON_THROW_IF(s!="a short token" || t!="a short token" || std::hash<small_str>()(d)!=std::hash<str>()(s), "err");
+    PROTON_THROW_IF(str_view(d)!=s || d!=s || d.find('t')!=6 || d.substr(2, 5)!="short", "err");
+    small_str e(1000, 'x');
+    e.resize(3);
+    e.assign(e.data()+1, 2);
+    PROTON_THROW_IF(e!="xx" || !(small_str("ab")<small_str("b")), "err");
+
+    vector_<small_str> v;
+    split(v, str("a bb ccc"), str(" "));
+    PROTON_THROW_IF(v.size()!=3 || v[2]!="ccc" || str("-").join(v)!="a-bb-ccc", "split");
+    std::ostringstream o;
+    o << v[1];
+    PROTON_THROW_IF(o.str()!="bb", "err");
+    small_wstr w(L"wide");
+    w+=L" string";
+    PROTON_THROW_IF(w!=L"wide string", "err");
+    return 0;
+}
+
+// the stream output of a number, as % did with streams
+template<typename V>
+str stream_fmt(V a, char conv)
+{
+    std::ostringstream o;
+    typedef typename std::conditional<sizeof(V)==1, int, V>::type P;
+    switch(conv){
+        case 'o': o << std::oct << (P)a; break;
+        case 'x': o << std::hex << (P)a; break;
+        case 'X': o << std::hex << std::uppercase << (P)a; break;
+        default: o << (P)a;
+    }
+    return o.str().c_str();
+}
+
+template<typename V>
+str stream_to(V n, int base)
+{
+    std::ostringstream o;
+    set_base(o, base, true);
+    o << n;
+    return o.str().c_str();
+}
+
+int format_ut()
+{
+    cout << "-> format_ut" << endl;
+    const char* convs="sfduoxX";
+    long long ints[]={0, 1, -1, 7, 8, 9, 10, 15, 16, 99, 100, 255, -256, 12345, -99999, 1LL<<40,
+                      (long long)(~0ULL>>1), -(long long)(~0ULL>>1)-1};
+    for(auto n: ints){
+        for(const char* c=convs; *c; c++){
+            str f=str("<%_>");
+            f[2]=*c;
+            PROTON_THROW_IF(f%_t(n)!="<"+stream_fmt(n, *c)+">", f << " " << n);
+            PROTON_THROW_IF(f%_t((int)n)!="<"+stream_fmt((int)n, *c)+">", f << " int " << n);
+            PROTON_THROW_IF(f%_t((short)n)!="<"+stream_fmt((short)n, *c)+">", f << " short " << n);
+            PROTON_THROW_IF(f%_t((unsigned long)n)!="<"+stream_fmt((unsigned long)n, *c)+">", f << " ul " << n);
+            PROTON_THROW_IF(f%_t((signed char)n)!="<"+stream_fmt((signed char)n, *c)+">", f << " char " << n);
+        }
+    }
+    double fs[]={0, 1, -1.5, 3.14159265358979, 1e20, 1.5e-7, 123456789.0, 0.1, 1.0/0.0};
+    for(auto x: fs){
+        std::ostringstream o, of;
+        o << x;
+        of << (float)x;
+        PROTON_THROW_IF("%f"%_t(x)!=o.str().c_str() || "%s"%_t(x)!=o.str().c_str()
+                        || "%s"%_t((float)x)!=of.str().c_str(), "float " << x);
+        if(x<1e18)
+            PROTON_THROW_IF("%d %x"%_t(x, x)!=stream_fmt((long long)x, 'd')+" "+stream_fmt((long long)x, 'x'), "err");
+    }
+    std::ostringstream ol;
+    ol << 2.5L;
+    PROTON_THROW_IF("%s"%_t(2.5L)!=ol.str().c_str(), "long double");
+
+    std::string ss("std");
+    PROTON_THROW_IF("%s|%s|%s|%s|%s"%_t("c", str("str"), ss, str_view("view"), 'A')!="c|str|std|view|65", "strings");
+    PROTON_THROW_IF("100%% %s%%"%_t(1)!="100% 1%" || "%%"%_t()!="%" || "a"%_t()!="a", "%%");
+    std::ostringstream ot;
+    ot << std::make_tuple(1, "a") << " and " << vector_<int>({1, 2});
+    PROTON_THROW_IF("%s and %s"%_t(std::make_tuple(1, "a"), vector_<int>({1, 2}))!=ot.str().c_str(), "stream output");
+    PROTON_THROW_IF(str("%s")%"single"!="single" || str("%d")%7!="7", "single arg");
+    PROTON_THROW_IF(L"%s=%d"%_t(L"w", 10)!=L"w=10" || L"%x"%_t(255)!=L"ff", "wide");
+    PROTON_THROW_IF(L"%s"%_t(2.5)!=L"2.5" || L"%s"%_t(wstr(L"ws"))!=L"ws", "wide");
+    const char* null_s=NULL;
+    PROTON_THROW_IF("[%s]"%_t(null_s)!="[]", "null");
+    PROTON_THROW_IF("%s"%_t(true)!="1", "bool");
+
+    const char* errs[]={"%", "%s %s", "%s", "%q", "%d"};
+    int k=0;
+    for(auto f: errs){
+        try{
+            if(k==2)
+                str(f)%_t(1, 2);
+            else if(k==4)
+                str(f)%_t("abc");
+            else
+                str(f)%_t(1);
+            PROTON_THROW_IF(1, "no error for " << f);
+        }
+        catch(std::invalid_argument&){
+        }
+        k++;
+    }
+    return 0;
+}
+
+int num_ut()
+{
+    cout << "-> num_ut" << endl;
+    long long ints[]={0, 1, -1, 8, 15, 16, 255, -256, 12345, 1LL<<40, (long long)(~0ULL>>1), -(long long)(~0ULL>>1)-1};
+    for(auto n: ints){
+        for(int base: {8, 10, 16}){
+            PROTON_THROW_IF(to_<str>(n, base)!=stream_to(n, base), n << " " << base);
+            PROTON_THROW_IF(to_<std::string>((int)n, base)!=stream_to((int)n, base).c_str(), n << " int " << base);
+            PROTON_THROW_IF(to_<str>((unsigned short)n, base)!=stream_to((unsigned short)n, base), n << " ushort " << base);
+        }
+        long long r;
+        PROTON_THROW_IF(!get_int(r, to_<str>(n)) || r!=n, n);
+        unsigned long long h;
+        PROTON_THROW_IF(!get_int(h, to_<str>(n, 16)) || h!=(unsigned long long)n, n);
+    }
+    PROTON_THROW_IF(to_<str>(1.5)!="1.5" || to_<str>(1e20)!="1e+20" || to_<str>(2.5f, 16)!="0x2.5"
+                    || to_<str>(0.25L)!="0.25", "float");
+    PROTON_THROW_IF(to_<str>('a')!="a" || to_<str>(true)!="1" || to_<str>(str("s"))!="s", "objects");
+
+    int x=0;
+    PROTON_THROW_IF(!get_int(x, "ffh") || x!=255 || !get_int(x, "0X1f") || x!=31
+                    || !get_int(x, str_view(" -12")) || x!=-12 || !get_int(x, "10", 16) || x!=16, "get_int");
+    const char* bad[]={"", "0x", "12 ", "1 2", "- 1", "12a", "2147483648", "-2147483649", "ffffffffh"};
+    for(auto s: bad)
+        PROTON_THROW_IF(get_int(x, s), s);
+    PROTON_THROW_IF(!get_int(x, "-2147483648") || x!=(int)0x80000000, "int min");
+    unsigned u;
+    PROTON_THROW_IF(!get_int(u, "-1") || u!=~0u || get_int(u, "4294967296"), "unsigned");
+    short sh;
+    PROTON_THROW_IF(!get_int(sh, "7fffh") || sh!=32767 || get_int(sh, "8000h"), "short");
+    str s="12345";
+    PROTON_THROW_IF(!get_int(x, str_view(s.data(), 3)) || x!=123, "view");
+
+    double d;
+    PROTON_THROW_IF(!get_float(d, "1.5") || d!=1.5 || !get_float(d, " -2e3") || d!=-2e3 || !get_float(d, ".5") || d!=0.5, "get_float");
+    const char* bad_floats[]={"", "1e", "1.5 ", "inf", "nan", "0x1p3", "1e400", "1,5"};
+    for(auto s: bad_floats)
+        PROTON_THROW_IF(get_float(d, s), s);
+    float f;
+    PROTON_THROW_IF(!get_float(f, str_view("0.25x", 4)) || f!=0.25f || get_float(f, "1e40"), "float");
+    return 0;
+}
+
+int main()
+{
+    proton::debug_level=1;
+    proton::wait_on_err=0;
+    std::vector<proton::detail::unittest_t> ut=
+        {kernel_ut, case_ut, split_ut, view_ut, lazy_ut, join_ut, small_str_ut, format_ut, num_ut};
+    return proton::detail::unittest_run(ut);
+}
@@ -0,0 +1,124 @@
+#include <iostream>
+#include <thread>
+#include <vector>
+#include <atomic>
+#include <proton/base.hpp>
+#include <proton/string.hpp>
+#include <proton/map.hpp>
+#include <proton/unordered_map.hpp>
+#include <proton/symbol.hpp>
+#include <proton/detail/unit_test.hpp>
+
+using namespace std;
+using namespace proton;
+
+int api_ut()
+{
+    cout << "-> api_ut" << endl;
+    size_t n0=symbol_count();
+    symbol a("host"), b(str("host")), c(std::string("port")), e;
+    PROTON_THROW_IF(a!=b || a==c || a.data()!=b.data() || symbol_count()!=n0+2, "err");
+    PROTON_THROW_IF(a.size()!=4 || a.c_str()[4]!=0 || str(a)!="host" || str_view(c)!="port", "err");
+    PROTON_THROW_IF(!e.empty() || symbol("")!=e || intern("host")!=a, "err");
+    PROTON_THROW_IF(std::hash<symbol>()(a)!=std::hash<str>()(str("host")), "hash");
+    PROTON_THROW_IF(std::hash<symbol>()(e)!=std::hash<str>()(str()), "hash of empty");
+    PROTON_THROW_IF(!(a<c) || c<a || a<a || !(e<a), "order");
+
+    bool found;
+    PROTON_THROW_IF(symbol::find("port", found)!=c || !found, "err");
+    symbol::find("no such symbol", found);
+    PROTON_THROW_IF(found || symbol_count()!=n0+2, "find adds");
+
+    std::ostringstream o;
+    o << a << ":" << c;
+    PROTON_THROW_IF(o.str()!="host:port", "err");
+
+    map_<symbol, int> m;
+    m[symbol("b")]=2;
+    m[symbol("a")]=1;
+    PROTON_THROW_IF(m.begin()->first!=symbol("a") || m[symbol("b")]!=2, "map_");
+    unordered_map_<symbol, int> u;
+    u[a]=1;
+    PROTON_THROW_IF(u[symbol("host")]!=1, "unordered_map_");
+
+    // many symbols in a shard, through rehashing
+    vector<symbol> v;
+    for(int i=0; i<5000; i++)
+        v.push_back(symbol(str("key_%d") % _t(i)));
+    for(int i=0; i<5000; i++){
+        str s=str("key_%d") % _t(i);
+        PROTON_THROW_IF(symbol(s)!=v[i] || str(v[i])!=s, "lost " << s);
+    }
+    PROTON_THROW_IF(symbol_count()!=n0+2+2+5000, "count");
+    return 0;
+}
+
+int threads_ut()
+{
+    cout << "-> threads_ut" << endl;
+    const int n=4, keys=20000;
+    vector<vector<symbol> > r(n);
+    vector<thread> ts;
+    for(int t=0; t<n; t++){
+        ts.emplace_back([t, &r](){
+            // the same keys in different orders
+            for(int i=0; i<keys; i++){
+                int k=(t%2 ? keys-1-i : i);
+                char buf[32];
+                snprintf(buf, sizeof(buf), "thread_key_%d", k);
+                r[t].push_back(symbol(buf));
+            }
+        });
+    }
+    for(auto& t: ts)
+        t.join();
+    for(int t=1; t<n; t++)
+        for(int i=0; i<keys; i++)
+            PROTON_THROW_IF(r[t][t%2 ? keys-1-i : i]!=r[0][i], "different symbols of a key");
+    bool found;
+    symbol::find("thread_key_123", found);
+    PROTON_THROW_IF(!found, "err");
+    return 0;
+}
+
+int find_ut()
+{
+    cout << "-> find_ut" << endl;
+    // interned keys are found while inserts rehash their shards
+    const int keys=2000, inserts=100000;
+    vector<symbol> v;
+    for(int i=0; i<keys; i++)
+        v.push_back(symbol("find_key_"+to_<str>(i)));
+    std::atomic<bool> done(false);
+    std::atomic<int> missed(0);
+    vector<thread> ts;
+    ts.emplace_back([&](){
+        for(int i=0; i<inserts; i++)
+            symbol("find_new_"+to_<str>(i));
+        done=true;
+    });
+    for(int t=0; t<3; t++){
+        ts.emplace_back([&](){
+            do{
+                for(int i=0; i<keys; i++){
+                    bool found;
+                    if(symbol::find("find_key_"+to_<str>(i), found)!=v[i] || !found)
+                        missed++;
+                }
+            }while(!done);
+        });
+    }
+    for(auto& t: ts)
+        t.join();
+    PROTON_THROW_IF(missed!=0, missed << " interned keys not found");
+    return 0;
+}
+
+int main()
+{
+    proton::debug_level=1;
+    proton::wait_on_err=0;
+    std::vector<proton::detail::unittest_t> ut=
+        {api_ut, threads_ut, find_ut};
+    return proton::detail::unittest_run(ut);
+}